@@ -0,0 +1,206 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 微基准测试框架
+// 只计时一次、用毫秒做单位的测法有几个问题：第一次运行要处理缺页、冷cache，vector扩容的次数不受控制，
+// 毫秒的分辨率对几毫秒的测试太粗，一次的结果也看不出波动。Harness对每个测试：
+// 1. 先运行warmup次不计时(预热页表、cache、malloc的空闲链表)，再计时运行repeat次；
+// 2. 每次运行前调用setup()在计时之外准备好状态(例如构造并reserve好vector)，计时结束后状态才析构，
+//    所以准备和释放都不计入，每次运行互不影响；
+// 3. 用steady_clock按纳秒计时，结果除以ops得到每个操作的ns，统计min、中位数、p99、平均值；
+// 4. 每个结果带一组参数(N、是否reserve……)，扫参数时多个结果可以一起输出成表格、CSV或JSON。
+namespace bench
+{
+    // 一组测试参数，按加入的顺序输出，例如{{"N", "100000"}, {"reserve", "yes"}}
+    typedef std::vector<std::pair<std::string, std::string>> Params;
+
+    // 每个操作的耗时(ns)
+    struct Stats
+    {
+        size_t runs;
+        double minNs;
+        double medianNs;
+        double p99Ns;
+        double meanNs;
+    };
+
+    struct Result
+    {
+        std::string name;
+        Params params;
+        size_t ops; // 每次运行的操作数
+        Stats stats;
+    };
+
+    // 让编译器认为v被读写过，不能把产生v的计算删掉
+    template <typename T>
+    inline void doNotOptimize(T &v)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "g"(&v) : "memory");
+#else
+        static T *volatile sink;
+        sink = &v;
+#endif
+    }
+
+    // 已排序的样本，nearest-rank法取第p(0~100)百分位
+    inline double percentile(const std::vector<double> &sorted, double p)
+    {
+        size_t rank = size_t(std::ceil(p / 100 * sorted.size()));
+        return sorted[rank == 0 ? 0 : rank - 1];
+    }
+
+    inline Stats summarize(std::vector<double> samples)
+    {
+        std::sort(samples.begin(), samples.end());
+        double sum = 0;
+        for (double s : samples)
+            sum += s;
+        return Stats{samples.size(), samples.front(), percentile(samples, 50), percentile(samples, 99), sum / samples.size()};
+    }
+
+    class Harness
+    {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        // repeat次数太少时p99就是最大值：nearest-rank要100次以上才会去掉最慢的一次
+        explicit Harness(int warmup = 3, int repeat = 31) : warmup(warmup), repeat(std::max(1, repeat)) {}
+
+        // setup()返回本次运行的状态，body(state)是被计时的部分，ops是body中的操作数。
+        // 返回结果的副本：results之后还会push_back，引用会失效
+        template <typename Setup, typename Body>
+        Result run(const std::string &name, const Params &params, size_t ops, Setup setup, Body body)
+        {
+            std::vector<double> samples;
+            samples.reserve(repeat);
+            for (int i = -warmup; i < repeat; ++i)
+            {
+                auto state = setup();
+                auto start = clock::now();
+                body(state);
+                doNotOptimize(state);
+                std::chrono::duration<double, std::nano> d = clock::now() - start;
+                if (i >= 0)
+                    samples.push_back(d.count() / (ops ? ops : 1));
+            }
+            results.push_back(Result{name, params, ops, summarize(samples)});
+            return results.back();
+        }
+
+        const std::vector<Result> &all() const { return results; }
+
+        void printTable(std::ostream &out) const
+        {
+            FormatGuard guard(out);
+            std::vector<std::string> labels;
+            size_t width = 4;
+            for (const Result &r : results)
+            {
+                std::string label = r.name;
+                for (const auto &p : r.params)
+                    label += " " + p.first + "=" + p.second;
+                width = std::max(width, label.size() + 2);
+                labels.push_back(label);
+            }
+            out << std::left << std::setw(int(width)) << "test" << std::right << std::setw(12) << "median ns" << std::setw(12)
+                << "p99 ns" << std::setw(12) << "min ns" << std::setw(12) << "mean ns" << std::endl;
+            for (size_t i = 0; i < results.size(); ++i)
+            {
+                const Stats &s = results[i].stats;
+                out << std::left << std::setw(int(width)) << labels[i] << std::right << std::fixed << std::setprecision(2)
+                    << std::setw(12) << s.medianNs << std::setw(12) << s.p99Ns << std::setw(12) << s.minNs
+                    << std::setw(12) << s.meanNs << std::endl;
+            }
+        }
+
+        // 参数名取所有结果中出现过的，按第一次出现的顺序作为列；某个结果没有的参数留空
+        void writeCsv(std::ostream &out) const
+        {
+            FormatGuard guard(out);
+            std::vector<std::string> keys = paramKeys();
+            out << "name";
+            for (const std::string &k : keys)
+                out << "," << k;
+            out << ",ops,runs,min_ns,median_ns,p99_ns,mean_ns" << std::endl;
+            for (const Result &r : results)
+            {
+                out << r.name;
+                for (const std::string &k : keys)
+                    out << "," << lookup(r.params, k);
+                out << "," << r.ops << "," << r.stats.runs << std::fixed << std::setprecision(3) << "," << r.stats.minNs
+                    << "," << r.stats.medianNs << "," << r.stats.p99Ns << "," << r.stats.meanNs << std::endl;
+            }
+        }
+
+        void writeJson(std::ostream &out) const
+        {
+            FormatGuard guard(out);
+            out << "{\n  \"compiler\": \"" <<
+#ifdef __VERSION__
+                __VERSION__
+#else
+                "unknown"
+#endif
+                << "\",\n  \"warmup\": " << warmup << ",\n  \"repeat\": " << repeat << ",\n  \"results\": [\n";
+            for (size_t i = 0; i < results.size(); ++i)
+            {
+                const Result &r = results[i];
+                out << "    {\"name\": \"" << r.name << "\", \"params\": {";
+                for (size_t j = 0; j < r.params.size(); ++j)
+                    out << (j ? ", " : "") << "\"" << r.params[j].first << "\": \"" << r.params[j].second << "\"";
+                out << "}, \"ops\": " << r.ops << ", \"runs\": " << r.stats.runs << std::fixed << std::setprecision(3)
+                    << ", \"min_ns\": " << r.stats.minNs << ", \"median_ns\": " << r.stats.medianNs
+                    << ", \"p99_ns\": " << r.stats.p99Ns << ", \"mean_ns\": " << r.stats.meanNs << "}"
+                    << (i + 1 < results.size() ? "," : "") << "\n";
+            }
+            out << "  ]\n}" << std::endl;
+        }
+
+    private:
+        // 输出时改了精度和格式，结束后恢复，不影响调用者之后的输出
+        struct FormatGuard
+        {
+            std::ostream &out;
+            std::ios_base::fmtflags flags;
+            std::streamsize precision;
+            explicit FormatGuard(std::ostream &out) : out(out), flags(out.flags()), precision(out.precision()) {}
+            ~FormatGuard()
+            {
+                out.flags(flags);
+                out.precision(precision);
+            }
+        };
+
+        std::vector<std::string> paramKeys() const
+        {
+            std::vector<std::string> keys;
+            for (const Result &r : results)
+                for (const auto &p : r.params)
+                    if (std::find(keys.begin(), keys.end(), p.first) == keys.end())
+                        keys.push_back(p.first);
+            return keys;
+        }
+
+        static std::string lookup(const Params &params, const std::string &key)
+        {
+            for (const auto &p : params)
+                if (p.first == key)
+                    return p.second;
+            return "";
+        }
+
+        int warmup;
+        int repeat;
+        std::vector<Result> results;
+    };
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include "myString.hpp"
+
+// 字符串驻留(interning)：每个不同的字符串只存一份MyString，intern()返回指向它的句柄InternedString。
+// 同一个池中内容相同的字符串得到同一个句柄，比较相等只需比较指针，哈希直接用驻留时分配的编号，
+// 不用再逐字符比较、逐字符计算哈希；大量重复的字符串(例如姓名)也只占一份内存。
+// 驻留的字符串在池析构前一直有效，不会删除。
+class InternPool;
+
+class InternedString
+{
+public:
+    InternedString() : _entry(nullptr) {}
+
+    const char *c_str() const { return _entry ? _entry->text.c_str() : ""; }
+    size_t size() const { return _entry ? _entry->text.size() : 0; }
+    bool empty() const { return size() == 0; }
+    // 在池中的编号，从0开始连续分配；空句柄是-1
+    size_t id() const { return _entry ? _entry->id : size_t(-1); }
+
+    // 同一个池驻留出来的句柄：内容相同 <=> 指针相同
+    bool operator==(const InternedString &other) const { return _entry == other._entry; }
+    bool operator!=(const InternedString &other) const { return _entry != other._entry; }
+
+private:
+    friend class InternPool;
+
+    struct Entry
+    {
+        MyString text;
+        size_t id;
+    };
+
+    explicit InternedString(const Entry *entry) : _entry(entry) {}
+
+    const Entry *_entry;
+};
+
+namespace std
+{
+    template <>
+    struct hash<InternedString>
+    {
+        size_t operator()(const InternedString &s) const { return hash<size_t>()(s.id()); }
+    };
+}
+
+// 按哈希值分成SHARDS个分段，每段一把锁、一张哈希表，多个线程驻留不同的字符串时很少抢同一把锁。
+// 字符串存放在每段的deque中：deque在尾部添加元素不会搬动已有的元素，
+// 所以句柄里的指针、哈希表key(string_view指向MyString的字符，短字符串就在MyString对象内部)一直有效。
+class InternPool
+{
+public:
+    static const size_t SHARDS = 16;
+
+    struct Stats
+    {
+        size_t strings; // 不同的字符串个数
+        size_t bytes;   // 字符串占用的字节数：MyString对象本身 + 堆上的字符
+    };
+
+    InternPool() = default;
+    InternPool(const InternPool &) = delete;
+    InternPool &operator=(const InternPool &) = delete;
+
+    InternedString intern(const char *str, size_t len)
+    {
+        std::string_view key(str, len);
+        size_t h = std::hash<std::string_view>()(key);
+        Shard &shard = shards[h % SHARDS];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end())
+            return InternedString(it->second);
+
+        size_t id = nextId++;
+        shard.entries.push_back(InternedString::Entry{MyString(str, len), id});
+        const InternedString::Entry *entry = &shard.entries.back();
+        shard.index.emplace(std::string_view(entry->text.c_str(), len), entry);
+        return InternedString(entry);
+    }
+    InternedString intern(const char *str) { return intern(str, strlen(str)); }
+    InternedString intern(std::string_view str) { return intern(str.data(), str.size()); }
+
+    Stats stats()
+    {
+        Stats s{0, 0};
+        for (Shard &shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            s.strings += shard.entries.size();
+            for (const InternedString::Entry &e : shard.entries)
+                s.bytes += sizeof(MyString) + (e.text.isShort() ? 0 : e.text.capacity() + 1);
+        }
+        return s;
+    }
+
+    // 没有指定池时使用的全局池
+    static InternPool &global()
+    {
+        static InternPool pool;
+        return pool;
+    }
+
+private:
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string_view, const InternedString::Entry *> index;
+        std::deque<InternedString::Entry> entries;
+    };
+
+    Shard shards[SHARDS];
+    std::atomic<size_t> nextId{0};
+};
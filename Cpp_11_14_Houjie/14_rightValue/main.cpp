@@ -1,127 +1,83 @@
 #include <iostream>
+#include <fstream>
+#include <string>
 #include <cstring>
 #include <chrono>
 #include <vector>
+#include <thread>
+#include "myString.hpp"
+#include "sharedString.hpp"
+#include "benchHarness.hpp"
 using namespace std;
 
-class MyString
+// 测试函数，演示右值引用和移动语义；计时交给bench::Harness
+template <typename M>
+void test_moveable(M &&c, long &value)
 {
-public:
-    static bool DebugLog;
-
-private:
-    char *_data;
-
-public:
-    // 默认构造
-    MyString() : _data(nullptr)
-    {
-        cout << "MyString default constructor" << endl;
-    }
-
-    // 带参构造
-    explicit MyString(const char *str)
-    {
-        if (str)
-        {
-            _data = new char[strlen(str) + 1];
-            strcpy(_data, str);
-        }
-        else
-        {
-            _data = nullptr;
-        }
-        if (DebugLog)
-            cout << "MyString constructor(const char *) " << endl;
-    }
-
-    // 拷贝构造函数（深拷贝）
-    MyString(const MyString &other)
+    for (long i = 0; i < value; ++i)
     {
-        if (other._data)
-        {
-            _data = new char[strlen(other._data) + 1];
-            strcpy(_data, other._data);
-        }
-        else
-            _data = nullptr;
-        if (DebugLog)
-            cout << "MyString copy constructor" << endl;
+        MyString str("test");
+        c.insert(c.end(), std::move(str));
     }
+}
 
-    // 移动构造函数（转移资源）
-    MyString(MyString &&other) noexcept : _data(other._data)
-    {
-        other._data = nullptr;
-        if (DebugLog)
-            cout << "MyString move constructor" << endl;
-    }
+// 原来的MyString没有append，只能每次strlen求出两段的长度，分配刚好够用的新缓冲区再strcpy/strcat
+void naive_append(MyString &s, const char *t)
+{
+    char *buf = new char[strlen(s.c_str()) + strlen(t) + 1];
+    strcpy(buf, s.c_str());
+    strcat(buf, t);
+    s = MyString(buf);
+    delete[] buf;
+}
 
-    // 拷贝赋值运算符
-    MyString &operator=(const MyString &other)
+// threads个线程同时把同一个src拷进各自的vector，每个线程拷perThread次，再全部析构，取3次中最快的一次
+template <typename S>
+double share_bench(const S &src, int threads, long perThread)
+{
+    double best = 1e18;
+    for (int r = 0; r < 3; ++r)
     {
-        if (this != &other)
-        {
-            delete[] _data;
-            if (other._data)
-            {
-                _data = new char[strlen(other._data) + 1];
-                strcpy(_data, other._data);
-            }
-            else
-            {
-                _data = nullptr;
-            }
-        }
-        if (DebugLog)
-            cout << "MyString copy assignment operator" << endl;
-        return *this;
+        auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (int t = 0; t < threads; ++t)
+            workers.emplace_back([&]
+                                 {
+                                     vector<S> vec;
+                                     vec.reserve(perThread);
+                                     for (long i = 0; i < perThread; ++i)
+                                         vec.push_back(src); });
+        for (thread &w : workers)
+            w.join();
+        chrono::duration<double, milli> dur = chrono::steady_clock::now() - start;
+        best = min(best, dur.count());
     }
+    return best;
+}
 
-    // 移动赋值运算符
-    MyString &operator=(MyString &&other) noexcept
+// 14_rightValue [--repeat=31] [--csv=FILE] [--json=FILE]
+// 第2节和test_moveable的结果除了打印表格，还可以写成CSV、JSON文件
+int main(int argc, char *argv[])
+{
+    int repeat = 31;
+    string csvPath, jsonPath;
+    for (int i = 1; i < argc; ++i)
     {
-        if (this != &other)
+        string arg = argv[i];
+        if (arg.rfind("--repeat=", 0) == 0)
+            repeat = max(1, stoi(arg.substr(9)));
+        else if (arg.rfind("--csv=", 0) == 0)
+            csvPath = arg.substr(6);
+        else if (arg.rfind("--json=", 0) == 0)
+            jsonPath = arg.substr(7);
+        else
         {
-            delete[] _data;
-            _data = other._data;
-            other._data = nullptr;
+            cerr << "usage: " << argv[0] << " [--repeat=31] [--csv=FILE] [--json=FILE]" << endl;
+            return 1;
         }
-        if (DebugLog)
-            cout << "MyString move assignment operator" << endl;
-        return *this;
-    }
-
-    // 析构函数
-    ~MyString()
-    {
-        delete[] _data;
-        if (DebugLog)
-            cout << "MyString destructor" << endl;
     }
+    bench::Harness harness(3, repeat);
 
-    const char *c_str() const { return _data ? _data : ""; }
-};
-bool MyString::DebugLog = false;
-
-// 测试函数，演示右值引用和移动语义
-template <typename M>
-void test_moveable(M &&c, long &value)
-{
-    auto start = chrono::high_resolution_clock::now();
-    for (long i = 0; i < value; ++i)
-    {
-        MyString str("test");
-        c.insert(c.end(), std::move(str));
-    }
-
-    auto end = chrono::high_resolution_clock::now();
-    auto duration = chrono::duration_cast<chrono::milliseconds>(end - start);
-    cout << "Time taken: " << duration.count() << " ms" << endl;
-}
-
-int main()
-{
     // 1. 基础测试，验证拷贝和移动行为
     {
         MyString::DebugLog = true;
@@ -130,43 +86,111 @@ int main()
         MyString s3 = std::move(s1); // 移动构造，s1资源被转移到s3
         cout << "s2: " << s2.c_str() << endl;
         cout << "s3: " << s3.c_str() << endl;
+        cout << "sizeof(MyString) = " << sizeof(MyString) << ", s3 is " << (s3.isShort() ? "inline" : "on the heap") << endl;
     }
 
     // 2. 性能测试，对比vector插入时的拷贝和移动开销
+    //    "data"在对象内部(SSO)，另一个超过15个字符，仍然要new char[]
+    //    扫描N、是否预先reserve、插入方式(拷贝insert、移动insert、直接emplace)，每种组合预热3次、计时repeat次
     {
         MyString::DebugLog = false;
-        const long N = 100000;
-        vector<MyString> vec_copy;
-        vector<MyString> vec_move;
+        cout << "\n --- Test copy / move / emplace insertion (ns per element) ---" << endl;
+        for (const char *payload : {"data", "data that does not fit in 15 chars"})
+            for (long n : {1000L, 10000L, 100000L})
+                for (bool reserve : {false, true})
+                {
+                    bench::Params params = {{"chars", to_string(strlen(payload))}, {"N", to_string(n)}, {"reserve", reserve ? "yes" : "no"}};
+                    auto setup = [=]
+                    {
+                        vector<MyString> vec;
+                        if (reserve)
+                            vec.reserve(n);
+                        return vec;
+                    };
+                    harness.run("insert(copy)", params, n, setup, [=](vector<MyString> &vec)
+                                {
+                                    for (long i = 0; i < n; ++i)
+                                    {
+                                        MyString str(payload);
+                                        vec.insert(vec.end(), str);
+                                    } });
+                    harness.run("insert(move)", params, n, setup, [=](vector<MyString> &vec)
+                                {
+                                    for (long i = 0; i < n; ++i)
+                                    {
+                                        MyString str(payload);
+                                        vec.insert(vec.end(), std::move(str));
+                                    } });
+                    harness.run("emplace", params, n, setup, [=](vector<MyString> &vec)
+                                {
+                                    for (long i = 0; i < n; ++i)
+                                        vec.emplace(vec.end(), payload); });
+                }
+        harness.printTable(cout);
+    }
 
-        cout << "\n --- Test copy insertion ---" << endl;
-        auto start_copy = chrono::high_resolution_clock::now();
-        for (long i = 0; i < N; ++i)
+    // 3. 逐段拼接：n次append的总代价，几何增长是O(n)，每次刚好够用是O(n²)
+    {
+        MyString::DebugLog = false;
+        cout << "\n --- Test append \"abc\" n times ---" << endl;
+        for (long n : {1000L, 10000L, 50000L})
         {
-            MyString str("data");
-            vec_copy.insert(vec_copy.end(), str);
+            MyString a("");
+            auto start = chrono::steady_clock::now();
+            for (long i = 0; i < n; ++i)
+                a += "abc";
+            chrono::duration<double, milli> dur_append = chrono::steady_clock::now() - start;
+
+            MyString b("");
+            start = chrono::steady_clock::now();
+            for (long i = 0; i < n; ++i)
+                naive_append(b, "abc");
+            chrono::duration<double, milli> dur_naive = chrono::steady_clock::now() - start;
+            cout << "n = " << n << ": operator+= " << dur_append.count() << " ms (size " << a.size() << ", capacity "
+                 << a.capacity() << "), strlen+strcpy " << dur_naive.count() << " ms" << endl;
         }
-        auto end_copy = chrono::high_resolution_clock::now();
-        auto dur_copy = chrono::duration_cast<chrono::milliseconds>(end_copy - start_copy);
-        cout << "Copy insertion time: " << dur_copy.count() << " ms" << endl;
+    }
 
-        auto start_move = chrono::high_resolution_clock::now();
-        for (long i = 0; i < N; ++i)
+    // 4. 多线程共享：同一个字符串被拷进很多容器，MyString每次深拷贝，SharedString只加引用计数
+    {
+        MyString::DebugLog = false;
+        const long N = 100000;
+        for (const char *payload : {"data", "data that does not fit in 15 chars"})
         {
-            MyString str("data");
-            vec_move.insert(vec_move.end(), std::move(str));
+            MyString ms(payload);
+            SharedString ss(payload);
+            cout << "\n --- Test sharing one string (" << strlen(payload) << " chars), " << N << " copies per thread ---" << endl;
+            for (int threads : {1, 4})
+            {
+                double t_my = share_bench(ms, threads, N);
+                double t_shared = share_bench(ss, threads, N);
+                cout << threads << " thread(s): MyString " << t_my << " ms, SharedString " << t_shared << " ms" << endl;
+            }
+            cout << "sizeof(SharedString) = " << sizeof(SharedString) << ", use_count after benchmark = " << ss.use_count() << endl;
         }
-        auto end_move = chrono::high_resolution_clock::now();
-        auto dur_move = chrono::duration_cast<chrono::milliseconds>(end_move - start_move);
-        cout << "Move insertion time: " << dur_move.count() << " ms" << endl;
     }
 
     // template测试函数
     {
         MyString::DebugLog = false;
         long testSize = 10000;
-        vector<MyString> vec;
         cout << "\n --- Calling test_moveable ---" << endl;
-        test_moveable(vec, testSize);
+        bench::Result r = harness.run("test_moveable", {{"N", to_string(testSize)}}, testSize, []
+                                      { return vector<MyString>(); },
+                                      [&](vector<MyString> &vec)
+                                      { test_moveable(vec, testSize); });
+        cout << "Time taken: median " << r.stats.medianNs * testSize / 1000 << " us, p99 "
+             << r.stats.p99Ns * testSize / 1000 << " us (" << r.stats.runs << " runs)" << endl;
+    }
+
+    if (!csvPath.empty())
+    {
+        ofstream out(csvPath);
+        harness.writeCsv(out);
+    }
+    if (!jsonPath.empty())
+    {
+        ofstream out(jsonPath);
+        harness.writeJson(out);
     }
-}
\ No newline at end of file
+}
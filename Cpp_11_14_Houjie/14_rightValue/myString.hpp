@@ -0,0 +1,208 @@
+#pragma once
+#include <cstring>
+#include <iostream>
+
+// 带小字符串优化(SSO)的MyString
+// 原来的MyString只有一个char *_data，哪怕只有4个字符的"data"也要new char[]。
+// 这里不超过SSO_CAPACITY(15)个字符的字符串直接存放在对象内部的_local中，构造、拷贝、析构都不碰堆；
+// 更长的字符串才new char[]。_data总是指向当前存放字符的地方(_local或堆)，c_str()不需要分支。
+// 长度和容量都缓存在对象中：size()是O(1)，拷贝用memcpy，不再strlen重新扫描；
+// append/+=按容量的2倍增长，逐段拼接n次的总代价是O(n)而不是O(n²)。
+class MyString
+{
+public:
+    static inline bool DebugLog = false;
+    static const size_t SSO_CAPACITY = 15;
+
+private:
+    char *_data;  // 指向_local或堆上的缓冲区
+    size_t _size; // 字符数，不含'\0'
+    union
+    {
+        char _local[SSO_CAPACITY + 1]; // 短字符串存放在这里
+        size_t _capacity;              // 长字符串：堆上缓冲区能放的字符数(不含'\0')
+    };
+
+public:
+    // 默认构造
+    MyString() : _data(_local), _size(0)
+    {
+        _local[0] = '\0';
+        std::cout << "MyString default constructor" << std::endl;
+    }
+
+    // 带参构造
+    explicit MyString(const char *str)
+    {
+        init(str ? str : "", str ? strlen(str) : 0);
+        if (DebugLog)
+            std::cout << "MyString constructor(const char *) " << std::endl;
+    }
+
+    // 已知长度的构造，不需要strlen
+    MyString(const char *str, size_t len)
+    {
+        init(str, len);
+        if (DebugLog)
+            std::cout << "MyString constructor(const char *, size_t) " << std::endl;
+    }
+
+    // 拷贝构造函数（深拷贝；短字符串只是拷贝对象内的字节）
+    MyString(const MyString &other)
+    {
+        init(other._data, other._size);
+        if (DebugLog)
+            std::cout << "MyString copy constructor" << std::endl;
+    }
+
+    // 移动构造函数（长字符串转移堆上的缓冲区，短字符串拷贝_local）
+    MyString(MyString &&other) noexcept
+    {
+        steal(other);
+        if (DebugLog)
+            std::cout << "MyString move constructor" << std::endl;
+    }
+
+    // 拷贝赋值运算符
+    MyString &operator=(const MyString &other)
+    {
+        if (this != &other)
+            assign(other._data, other._size);
+        if (DebugLog)
+            std::cout << "MyString copy assignment operator" << std::endl;
+        return *this;
+    }
+
+    // 移动赋值运算符
+    MyString &operator=(MyString &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            steal(other);
+        }
+        if (DebugLog)
+            std::cout << "MyString move assignment operator" << std::endl;
+        return *this;
+    }
+
+    // 析构函数
+    ~MyString()
+    {
+        release();
+        if (DebugLog)
+            std::cout << "MyString destructor" << std::endl;
+    }
+
+    const char *c_str() const { return _data; }
+    size_t size() const { return _size; }
+    size_t length() const { return _size; }
+    bool empty() const { return _size == 0; }
+    // 不重新分配时最多能放的字符数
+    size_t capacity() const { return isShort() ? SSO_CAPACITY : _capacity; }
+
+    // 保证至少能放n个字符，只会变大
+    void reserve(size_t n)
+    {
+        if (n > capacity())
+            reallocate(n);
+    }
+
+    MyString &append(const char *str, size_t len)
+    {
+        if (_size + len > capacity())
+        {
+            // 几何增长：至少翻倍，连续append时每个字符平均只搬动常数次
+            size_t cap = capacity() * 2;
+            if (cap < _size + len)
+                cap = _size + len;
+            char *p = new char[cap + 1];
+            memcpy(p, _data, _size);
+            memcpy(p + _size, str, len); // 先拷贝再释放旧缓冲区，str指向自己时(s.append(s))也安全
+            release();
+            _data = p;
+            _capacity = cap;
+        }
+        else
+            memmove(_data + _size, str, len); // str可能与自己的缓冲区重叠
+        _size += len;
+        _data[_size] = '\0';
+        return *this;
+    }
+    MyString &append(const char *str) { return append(str, strlen(str)); }
+    MyString &append(const MyString &other) { return append(other._data, other._size); }
+
+    MyString &operator+=(const char *str) { return append(str); }
+    MyString &operator+=(const MyString &other) { return append(other); }
+    MyString &operator+=(char c) { return append(&c, 1); }
+
+    // 字符是否存放在对象内部
+    bool isShort() const { return _data == _local; }
+
+private:
+    // 按长度选择存放位置，拷贝len个字符
+    void init(const char *str, size_t len)
+    {
+        if (len <= SSO_CAPACITY)
+            _data = _local;
+        else
+        {
+            _data = new char[len + 1];
+            _capacity = len;
+        }
+        memcpy(_data, str, len);
+        _data[len] = '\0';
+        _size = len;
+    }
+
+    // 现有的缓冲区放得下就直接覆盖，放不下先分配新的再释放旧的
+    void assign(const char *str, size_t len)
+    {
+        size_t cap = isShort() ? SSO_CAPACITY : _capacity;
+        if (len > cap)
+        {
+            char *p = new char[len + 1];
+            release();
+            _data = p;
+            _capacity = len;
+        }
+        memcpy(_data, str, len);
+        _data[len] = '\0';
+        _size = len;
+    }
+
+    // 换成能放cap个字符的堆上缓冲区，保留现有内容
+    void reallocate(size_t cap)
+    {
+        char *p = new char[cap + 1];
+        memcpy(p, _data, _size + 1);
+        release();
+        _data = p;
+        _capacity = cap;
+    }
+
+    void release()
+    {
+        if (!isShort())
+            delete[] _data;
+    }
+
+    // 接管other的内容(调用前自己不持有堆内存)，other变为空串
+    void steal(MyString &other) noexcept
+    {
+        if (other.isShort())
+        {
+            _data = _local;
+            memcpy(_local, other._local, sizeof(_local)); // 定长的16字节，编译成一次SSE拷贝
+        }
+        else
+        {
+            _data = other._data;
+            _capacity = other._capacity;
+        }
+        _size = other._size;
+        other._data = other._local;
+        other._size = 0;
+        other._local[0] = '\0';
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstring>
+#include <new>
+
+// 引用计数的不可变字符串，MyString的兄弟类型
+// MyString的拷贝构造是深拷贝，长字符串每拷贝一次就new一次。同一个字符串被拷进很多容器时，
+// 字符其实不需要多份：SharedString只有一个指向Rep的指针，Rep的头部(引用计数、长度)和字符在同一次分配中，
+// 拷贝只是引用计数加1，最后一个副本析构时才释放。
+// 字符创建后不再修改，所以多个线程可以同时读、拷贝、析构指向同一个Rep的SharedString，只有计数是原子的。
+// 空串不分配，_rep为nullptr。
+class SharedString
+{
+private:
+    struct Rep
+    {
+        std::atomic<size_t> refs;
+        size_t size;
+        // 字符紧跟在头部之后
+        char *chars() { return reinterpret_cast<char *>(this + 1); }
+    };
+
+    Rep *_rep;
+
+public:
+    SharedString() noexcept : _rep(nullptr) {}
+
+    explicit SharedString(const char *str) : SharedString(str ? str : "", str ? strlen(str) : 0) {}
+
+    SharedString(const char *str, size_t len) : _rep(nullptr)
+    {
+        if (len == 0)
+            return;
+        // 头部和字符一次分配：少一次new，头部和字符也在相邻的cache line上
+        void *mem = ::operator new(sizeof(Rep) + len + 1);
+        _rep = new (mem) Rep{{1}, len};
+        memcpy(_rep->chars(), str, len);
+        _rep->chars()[len] = '\0';
+    }
+
+    // 拷贝：只增加引用计数。已经持有一个引用，不会与释放竞争，relaxed即可
+    SharedString(const SharedString &other) noexcept : _rep(other._rep)
+    {
+        if (_rep)
+            _rep->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    SharedString(SharedString &&other) noexcept : _rep(other._rep)
+    {
+        other._rep = nullptr;
+    }
+
+    // 先加后减，自己给自己赋值也安全
+    SharedString &operator=(const SharedString &other) noexcept
+    {
+        if (other._rep)
+            other._rep->refs.fetch_add(1, std::memory_order_relaxed);
+        release();
+        _rep = other._rep;
+        return *this;
+    }
+
+    SharedString &operator=(SharedString &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            _rep = other._rep;
+            other._rep = nullptr;
+        }
+        return *this;
+    }
+
+    ~SharedString() { release(); }
+
+    const char *c_str() const { return _rep ? _rep->chars() : ""; }
+    size_t size() const { return _rep ? _rep->size : 0; }
+    size_t length() const { return size(); }
+    bool empty() const { return _rep == nullptr; }
+    // 共享同一份字符的SharedString个数，只用于观察，多线程下读到的值随时可能过期
+    size_t use_count() const { return _rep ? _rep->refs.load(std::memory_order_relaxed) : 0; }
+
+private:
+    // 最后一个引用负责释放；acq_rel保证其它线程在减计数之前对字符的读都发生在释放之前
+    void release() noexcept
+    {
+        if (_rep && _rep->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            _rep->~Rep();
+            ::operator delete(_rep);
+        }
+    }
+};
@@ -2,8 +2,11 @@
 #include "variadicTemplate_printX.hpp"
 #include "variadicTemplate_hash.hpp"
 #include "variadicTemplate_tuple.hpp"
+#include <chrono>
+#include <vector>
 void testVaridicTemplatePrintX();
 void testVariadicTemplateHash();
+void testInternedCustomer();
 void testVariadicTemplateTuple();
 void test();
 
@@ -25,6 +28,88 @@ void testVariadicTemplateHash()
     cout << "Hash value of c1: " << hashFunc(c1) << endl;
     cout << "Hash value of c2: " << hashFunc(c2) << endl;
     cout << "Hash value of c3: " << hashFunc(c3) << endl; // Should be the same as c1
+    cout << "c1 == c3: " << boolalpha << (c1 == c3) << ", same fname storage: " << (c1.fname.c_str() == c3.fname.c_str()) << endl;
+    cout << "==========================================" << endl
+         << endl;
+}
+
+// 驻留之前的Customer，每个对象有自己的两份std::string
+struct PlainCustomer
+{
+    std::string fname;
+    std::string lname;
+    int no;
+
+    bool operator==(const PlainCustomer &other) const
+    {
+        return fname == other.fname && lname == other.lname && no == other.no;
+    }
+};
+
+struct PlainCustomerHash
+{
+    std::size_t operator()(const PlainCustomer &c) const { return hash_val(c.fname, c.lname, c.no); }
+};
+
+// N个Customer，名和姓各从64个中选，编号只有16种：统计与probe相等的个数，再对所有对象计算哈希
+template <typename C, typename Hash>
+void benchCustomers(const char *label, const vector<C> &all, size_t nameBytes)
+{
+    double eqBest = 1e18, hashBest = 1e18;
+    size_t equal = 0, sum = 0;
+    for (int r = 0; r < 5; ++r)
+    {
+        auto t0 = chrono::steady_clock::now();
+        equal = 0;
+        for (const C &c : all)
+            equal += (c == all[0]);
+        auto t1 = chrono::steady_clock::now();
+        for (const C &c : all)
+            sum += Hash()(c);
+        auto t2 = chrono::steady_clock::now();
+        eqBest = min(eqBest, chrono::duration<double, nano>(t1 - t0).count() / all.size());
+        hashBest = min(hashBest, chrono::duration<double, nano>(t2 - t1).count() / all.size());
+    }
+    cout << label << ": sizeof = " << sizeof(C) << ", name bytes = " << nameBytes << ", operator== " << eqBest
+         << " ns, hash " << hashBest << " ns (" << equal << " equal)" << endl;
+    // 不让编译器删掉哈希循环：sum必须算出来放进寄存器
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(sum));
+#else
+    static volatile size_t sink;
+    sink = sum;
+    (void)sink;
+#endif
+}
+
+void testInternedCustomer()
+{
+    cout << "------------TestInternedCustomer-------------" << endl;
+    const size_t N = 200000;
+    vector<string> first, last;
+    for (int i = 0; i < 64; ++i)
+    {
+        first.push_back("Firstname" + to_string(i));
+        last.push_back("Lastname-of-the-family-" + to_string(i)); // 超过15个字符，std::string要分配堆内存
+    }
+    vector<PlainCustomer> plain;
+    vector<Customer> interned;
+    plain.reserve(N);
+    interned.reserve(N);
+    size_t plainBytes = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        // 按固定的伪随机顺序选名字，相邻对象的名字不同
+        const string &f = first[(i * 7) % 64], &l = last[(i * 13 + i / 64) % 64];
+        plain.push_back(PlainCustomer{f, l, int(i % 16)});
+        interned.emplace_back(f, l, int(i % 16));
+        for (const string *s : {&f, &l})
+            plainBytes += sizeof(string) + (s->size() > 15 ? s->capacity() + 1 : 0);
+    }
+    InternPool::Stats st = InternPool::global().stats();
+    benchCustomers<PlainCustomer, PlainCustomerHash>("std::string ", plain, plainBytes);
+    benchCustomers<Customer, CustomerHash>("interned    ", interned, 2 * N * sizeof(InternedString) + st.bytes);
+    cout << "distinct strings in pool: " << st.strings << " (" << st.bytes << " bytes)" << endl;
     cout << "==========================================" << endl
          << endl;
 }
@@ -50,6 +135,7 @@ void test()
 {
     testVaridicTemplatePrintX();
     testVariadicTemplateHash();
+    testInternedCustomer();
     testVariadicTemplateTuple();
     testPrintf();
 }
\ No newline at end of file
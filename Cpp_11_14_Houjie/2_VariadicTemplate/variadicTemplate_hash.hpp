@@ -1,6 +1,8 @@
 #pragma once
 #include <cstddef>
 #include <functional>
+#include <string>
+#include "../14_rightValue/internPool.hpp"
 
 template <typename T>
 inline void hash_combine(size_t &seed, const T &val)
@@ -29,16 +31,23 @@ inline size_t hash_val(const Type &...args)
     return seed;
 }
 
+// 姓名重复率很高：名、姓都驻留在InternPool::global()中，相同的名字只存一份，
+// 比较两个Customer的姓名只比较指针，计算哈希只用驻留编号
 class Customer
 {
 public:
-    std::string fname; // first name
-    std::string lname; // last name
-    int no;            // number
+    InternedString fname; // first name
+    InternedString lname; // last name
+    int no;               // number
 
     // 构造函数
     Customer(const std::string &first, const std::string &last, int number)
-        : fname(first), lname(last), no(number) {}
+        : fname(InternPool::global().intern(first)), lname(InternPool::global().intern(last)), no(number) {}
+
+    bool operator==(const Customer &other) const
+    {
+        return fname == other.fname && lname == other.lname && no == other.no;
+    }
 };
 
 class CustomerHash
@@ -46,6 +55,6 @@ class CustomerHash
 public:
     std::size_t operator()(const Customer &c) const
     {
-        return hash_val(c.fname, c.lname, c.no); // 假设 Customer 类有一个名为 name 的 std::string 成员
+        return hash_val(c.fname, c.lname, c.no); // InternedString的哈希是驻留编号，不用扫描字符
     }
 };
\ No newline at end of file
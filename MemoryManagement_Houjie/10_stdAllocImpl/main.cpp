@@ -0,0 +1,185 @@
+#ifdef __GNUC__
+#include <ext/pool_allocator.h>
+#endif
+#include <memory>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <list>
+#include <map>
+#include <string>
+#include <chrono>
+#include "stdAlloc.hpp"
+using namespace std;
+
+template <typename Alloc>
+void cookie_test(Alloc alloc, size_t n)
+{
+    typename Alloc::value_type *p1, *p2, *p3;
+    p1 = alloc.allocate(n);
+    p2 = alloc.allocate(n);
+    p3 = alloc.allocate(n);
+    cout << "p1 = " << p1 << "\t" << "p2 = " << p2 << "\t" << "p3 = " << p3 << endl;
+    alloc.deallocate(p1, n);
+    alloc.deallocate(p2, n);
+    alloc.deallocate(p3, n);
+}
+
+// 返回每次操作的平均耗时(ns)，repeat轮取最小值，减少噪声
+template <typename F>
+double bench_ns(F f, size_t ops, int repeat = 5)
+{
+    double best = 1e300;
+    for (int r = 0; r < repeat; ++r)
+    {
+        auto start = chrono::steady_clock::now();
+        f();
+        chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+        best = min(best, d.count() / ops);
+    }
+    return best;
+}
+
+struct Obj16
+{
+    double a, b;
+};
+
+// 负载1：直接allocate/deallocate 16字节，先分配N个再逆序释放
+template <typename Alloc>
+double bench_raw(size_t N)
+{
+    typename allocator_traits<Alloc>::template rebind_alloc<Obj16> a;
+    vector<Obj16 *> p(N);
+    return bench_ns([&]()
+                    {
+                        for (size_t i = 0; i < N; ++i)
+                            p[i] = a.allocate(1);
+                        for (size_t i = N; i-- > 0;)
+                            a.deallocate(p[i], 1); },
+                    2 * N);
+}
+
+// 负载2：list<int>的push_back + clear，每个节点24字节
+template <typename Alloc>
+double bench_list(size_t N)
+{
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<int> IntAlloc;
+    return bench_ns([&]()
+                    {
+                        list<int, IntAlloc> l;
+                        for (size_t i = 0; i < N; ++i)
+                            l.push_back(int(i));
+                        l.clear(); },
+                    2 * N);
+}
+
+// 负载3：map<int, int>的insert + clear，每个节点40字节
+template <typename Alloc>
+double bench_map(size_t N)
+{
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<pair<const int, int>> PairAlloc;
+    return bench_ns([&]()
+                    {
+                        map<int, int, less<int>, PairAlloc> m;
+                        for (size_t i = 0; i < N; ++i)
+                            m.emplace(int(i * 7919 % N), int(i));
+                        m.clear(); },
+                    2 * N);
+}
+
+// 单独一个实例(inst = 1)，统计不受其他测试影响
+typedef default_alloc_template<false, 1> trace_alloc;
+
+void print_stats(const string &step)
+{
+    AllocStats s = trace_alloc::stats();
+    cout << left << setw(14) << step << right << setw(7) << s.heapSize << setw(7) << s.seaBytes << setw(7) << s.freeBytes
+         << setw(7) << s.inUseBytes << setw(10) << s.leftoverBytes << fixed << setprecision(2) << setw(7) << s.utilization
+         << setw(7) << s.externalFragmentation << "   ";
+    for (int i = 0; i < NFREELISTS; ++i)
+        if (s.freeListBytes[i])
+            cout << " #" << i << ":" << s.freeListBytes[i];
+    cout << endl;
+}
+
+template <typename Alloc>
+void bench_row(const string &name, size_t N)
+{
+    cout << left << setw(28) << name << right << fixed << setprecision(2)
+         << setw(10) << bench_raw<Alloc>(N)
+         << setw(10) << bench_list<Alloc>(N)
+         << setw(10) << bench_map<Alloc>(N) << endl;
+}
+
+int main()
+{
+    // 1. 与8_G2.9中的cookie_test对照：StdAlloc分配的区块紧挨着，间隔就是ROUND_UP(sizeof(T))
+    {
+        cookie_test(StdAlloc<double>(), 1);
+        cookie_test(StdAlloc<int>(), 3); // 12字节取整为16
+        cookie_test(std::allocator<double>(), 1);
+    }
+
+    // 2. 作为标准容器的分配器
+    {
+        vector<string, StdAlloc<string>> vec;
+        for (int i = 0; i < 10; ++i)
+            vec.push_back("hello" + to_string(i));
+        list<int, StdAlloc<int>> lst(vec.size(), 7);
+        map<int, string, less<int>, StdAlloc<pair<const int, string>>> mp;
+        for (size_t i = 0; i < vec.size(); ++i)
+            mp.emplace(int(i), vec[i]);
+        cout << "vec.back() = " << vec.back() << ", lst.size() = " << lst.size()
+             << ", mp[3] = " << mp[3] << endl;
+    }
+
+    // 3. 复现8_G2.9/Note.md中chunk_alloc的分析：每一步之后看战备池、free list和零头
+    {
+        cout << "\n"
+             << left << setw(14) << "step" << right << setw(7) << "heap" << setw(7) << "sea" << setw(7) << "free"
+             << setw(7) << "inUse" << setw(10) << "leftover" << setw(7) << "util" << setw(7) << "frag"
+             << "    free lists (#index:bytes)" << endl;
+        size_t sizes[] = {32, 64, 96, 88, 8, 104, 112, 48};
+        void *p[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            p[i] = trace_alloc::allocate(sizes[i]);
+            print_stats("allocate(" + to_string(sizes[i]) + ")");
+        }
+        for (int i = 0; i < 8; ++i)
+            trace_alloc::deallocate(p[i], sizes[i]);
+        print_stats("free all");
+
+        const int N = 1000000;
+        size_t sink = 0;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < N; ++i)
+            sink += trace_alloc::stats().freeBytes;
+        chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+        cout << "stats() = " << d.count() / N << " ns" << endl;
+        // 不让编译器删掉轮询循环：sink必须算出来放进寄存器
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r"(sink));
+#else
+        static volatile size_t keep;
+        keep = sink;
+        (void)keep;
+#endif
+    }
+
+    // 4. 吞吐量对比(ns/op，越小越好)
+    {
+        const size_t N = 200000;
+        cout << "\n"
+             << left << setw(28) << "allocator" << right
+             << setw(10) << "raw16" << setw(10) << "list" << setw(10) << "map" << endl;
+        bench_row<std::allocator<double>>("std::allocator", N);
+#ifdef __GNUC__
+        bench_row<__gnu_cxx::__pool_alloc<double>>("__gnu_cxx::__pool_alloc", N);
+#endif
+        bench_row<StdAlloc<double>>("StdAlloc<alloc>", N);
+        bench_row<StdAlloc<double, single_client_alloc>>("StdAlloc<single_client>", N);
+    }
+    return 0;
+}
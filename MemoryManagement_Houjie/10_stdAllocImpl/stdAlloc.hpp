@@ -0,0 +1,378 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+// 按照8_G2.9std_alloc_G4.9pool_alloc_G4.9allocator/Note.md中G2.9 std::alloc的源码实现
+// 一级配置器：malloc_alloc_template，二级配置器：default_alloc_template
+// 外加一个符合C++标准Allocator要求的StdAlloc<T>，可以直接写 vector<T, StdAlloc<T>>
+
+// ==================== 一级配置器 ====================
+template <int inst>
+class malloc_alloc_template
+{
+private:
+    static inline void (*malloc_alloc_oom_handler)() = nullptr;
+
+    static void *oom_malloc(size_t n)
+    {
+        for (;;)
+        {
+            void (*my_malloc_handler)() = malloc_alloc_oom_handler;
+            if (!my_malloc_handler)
+                throw std::bad_alloc();
+            my_malloc_handler(); // 呼叫handler，企图释放memory
+            void *result = malloc(n);
+            if (result)
+                return result;
+        }
+    }
+
+    static void *oom_realloc(void *p, size_t n)
+    {
+        for (;;)
+        {
+            void (*my_malloc_handler)() = malloc_alloc_oom_handler;
+            if (!my_malloc_handler)
+                throw std::bad_alloc();
+            my_malloc_handler();
+            void *result = realloc(p, n);
+            if (result)
+                return result;
+        }
+    }
+
+public:
+    static void *allocate(size_t n)
+    {
+        void *result = malloc(n);
+        if (!result)
+            result = oom_malloc(n);
+        return result;
+    }
+
+    static void deallocate(void *p, size_t /* n */)
+    {
+        free(p);
+    }
+
+    static void *reallocate(void *p, size_t /* old_sz */, size_t new_sz)
+    {
+        void *result = realloc(p, new_sz);
+        if (!result)
+            result = oom_realloc(p, new_sz);
+        return result;
+    }
+
+    static void (*set_malloc_handler(void (*f)()))()
+    {
+        void (*old)() = malloc_alloc_oom_handler;
+        malloc_alloc_oom_handler = f;
+        return old;
+    }
+};
+
+typedef malloc_alloc_template<0> malloc_alloc;
+
+// ==================== 二级配置器 ====================
+enum
+{
+    ALIGN = 8
+};
+enum
+{
+    MAX_BYTES = 128
+};
+enum
+{
+    NFREELISTS = MAX_BYTES / ALIGN
+};
+
+// 二级配置器的统计快照，见default_alloc_template::stats()
+struct AllocStats
+{
+    size_t heapSize;                    // heap_size：累计从malloc要来注入战备池的字节数
+    size_t chunkAllocs;                 // 战备池注水(malloc)的次数
+    size_t lastChunkBytes;              // 最近一次注水的字节数，随heap_size >> 4增长
+    size_t seaBytes;                    // end_free - start_free：战备池中还没切出去的字节数
+    size_t freeListBytes[NFREELISTS];   // 每条free list上空闲块的总字节数，下标i对应(i+1)*ALIGN字节的块
+    size_t freeBytes;                   // 所有free list之和
+    size_t leftoverPieces;              // 累计有多少块战备池零头被挂到较小的free list上
+    size_t leftoverBytes;               // 这些零头的总字节数
+    size_t inUseBytes;                  // 已经交给客户、还没归还的字节数 = heapSize - seaBytes - freeBytes
+    double utilization;                 // inUseBytes / heapSize
+    double externalFragmentation;       // 1 - 最大空闲块 / 全部空闲字节(free list + 战备池)，空闲为0时是0
+};
+
+// threads为true时，free list和战备池的操作都在一把锁内完成（与SGI的__STL_THREADS版本一致）
+template <bool threads, int inst>
+class default_alloc_template
+{
+private:
+    static size_t ROUND_UP(size_t bytes)
+    {
+        return (((bytes) + ALIGN - 1) & ~(size_t(ALIGN) - 1));
+    }
+
+    union obj
+    {
+        union obj *free_list_link;
+        char client_data[1];
+    };
+
+    static size_t FREELIST_INDEX(size_t bytes)
+    {
+        return (((bytes) + ALIGN - 1) / ALIGN - 1);
+    }
+
+    // 单线程版本的锁什么也不做
+    struct lock
+    {
+        lock()
+        {
+            if (threads)
+                mtx.lock();
+        }
+        ~lock()
+        {
+            if (threads)
+                mtx.unlock();
+        }
+    };
+
+    static void *refill(size_t n);
+    static char *chunk_alloc(size_t size, int &nobjs);
+
+    static inline obj *volatile free_list[NFREELISTS] = {};
+    static inline char *start_free = nullptr;
+    static inline char *end_free = nullptr;
+    static inline size_t heap_size = 0;
+    static inline std::mutex mtx;
+
+    // 统计计数。修改都发生在锁内(或单线程版本的唯一线程中)，所以用relaxed的load + store，
+    // 在x86上就是普通的mov，不需要lock前缀；stats()不加锁读取，可以从监控线程随时轮询
+    struct Counters
+    {
+        std::atomic<size_t> freeBlocks[NFREELISTS];
+        std::atomic<size_t> heapSize, chunkAllocs, lastChunkBytes, seaBytes, leftoverPieces, leftoverBytes;
+    };
+    static inline Counters counters = {};
+
+    static void add(std::atomic<size_t> &c, size_t d) { c.store(c.load(std::memory_order_relaxed) + d, std::memory_order_relaxed); }
+    static void sub(std::atomic<size_t> &c, size_t d) { c.store(c.load(std::memory_order_relaxed) - d, std::memory_order_relaxed); }
+
+public:
+    static void *allocate(size_t n)
+    {
+        if (n > (size_t)MAX_BYTES)
+            return malloc_alloc::allocate(n); // 改用第一级
+
+        obj *volatile *my_free_list = free_list + FREELIST_INDEX(n);
+        lock guard;
+        obj *result = *my_free_list;
+        if (result == nullptr)
+            return refill(ROUND_UP(n)); // refill()填充free list并返回第一个区块
+        *my_free_list = result->free_list_link;
+        sub(counters.freeBlocks[FREELIST_INDEX(n)], 1);
+        return result;
+    }
+
+    static void deallocate(void *p, size_t n)
+    {
+        if (n > (size_t)MAX_BYTES)
+        {
+            malloc_alloc::deallocate(p, n); // 改用第一级
+            return;
+        }
+        obj *q = static_cast<obj *>(p);
+        obj *volatile *my_free_list = free_list + FREELIST_INDEX(n);
+        lock guard;
+        q->free_list_link = *my_free_list;
+        *my_free_list = q;
+        add(counters.freeBlocks[FREELIST_INDEX(n)], 1);
+    }
+
+    static void *reallocate(void *p, size_t old_sz, size_t new_sz)
+    {
+        if (old_sz > (size_t)MAX_BYTES && new_sz > (size_t)MAX_BYTES)
+            return malloc_alloc::reallocate(p, old_sz, new_sz);
+        if (ROUND_UP(old_sz) == ROUND_UP(new_sz))
+            return p;
+        void *result = allocate(new_sz);
+        memcpy(result, p, new_sz > old_sz ? old_sz : new_sz);
+        deallocate(p, old_sz);
+        return result;
+    }
+
+    // 统计快照：不加锁，每个字段各自准确；其他线程同时在分配时，字段之间可能相差一两次操作
+    static AllocStats stats()
+    {
+        AllocStats st = {};
+        st.heapSize = counters.heapSize.load(std::memory_order_relaxed);
+        st.chunkAllocs = counters.chunkAllocs.load(std::memory_order_relaxed);
+        st.lastChunkBytes = counters.lastChunkBytes.load(std::memory_order_relaxed);
+        st.seaBytes = counters.seaBytes.load(std::memory_order_relaxed);
+        st.leftoverPieces = counters.leftoverPieces.load(std::memory_order_relaxed);
+        st.leftoverBytes = counters.leftoverBytes.load(std::memory_order_relaxed);
+        size_t largest = st.seaBytes;
+        for (int i = 0; i < NFREELISTS; ++i)
+        {
+            size_t blocks = counters.freeBlocks[i].load(std::memory_order_relaxed);
+            st.freeListBytes[i] = blocks * (i + 1) * ALIGN;
+            st.freeBytes += st.freeListBytes[i];
+            if (blocks && size_t(i + 1) * ALIGN > largest)
+                largest = (i + 1) * ALIGN;
+        }
+        size_t idle = st.seaBytes + st.freeBytes;
+        st.inUseBytes = st.heapSize > idle ? st.heapSize - idle : 0;
+        st.utilization = st.heapSize ? double(st.inUseBytes) / st.heapSize : 0;
+        st.externalFragmentation = idle ? 1 - double(largest) / idle : 0;
+        return st;
+    }
+};
+
+// 调用者已持有锁
+template <bool threads, int inst>
+char *default_alloc_template<threads, inst>::chunk_alloc(size_t size, int &nobjs)
+{
+    char *result;
+    size_t total_bytes = size * nobjs;
+    size_t bytes_left = end_free - start_free;
+    if (bytes_left >= total_bytes)
+    {
+        result = start_free;
+        start_free += total_bytes;
+        return result;
+    }
+    else if (bytes_left >= size)
+    {
+        nobjs = int(bytes_left / size);
+        total_bytes = size * nobjs;
+        result = start_free;
+        start_free += total_bytes;
+        return result;
+    }
+    else
+    {
+        size_t bytes_to_get = 2 * total_bytes + ROUND_UP(heap_size >> 4);
+        // 战备池的零头挂到对应的free list上
+        if (bytes_left > 0)
+        {
+            obj *volatile *my_free_list = free_list + FREELIST_INDEX(bytes_left);
+            ((obj *)start_free)->free_list_link = *my_free_list;
+            *my_free_list = (obj *)start_free;
+            add(counters.freeBlocks[FREELIST_INDEX(bytes_left)], 1);
+            add(counters.leftoverPieces, 1);
+            add(counters.leftoverBytes, bytes_left);
+        }
+        start_free = (char *)malloc(bytes_to_get);
+        if (start_free == nullptr)
+        {
+            // 从更大的free list中找一块回填战备池
+            for (size_t i = size; i <= (size_t)MAX_BYTES; i += ALIGN)
+            {
+                obj *volatile *my_free_list = free_list + FREELIST_INDEX(i);
+                obj *p = *my_free_list;
+                if (p != nullptr)
+                {
+                    *my_free_list = p->free_list_link;
+                    sub(counters.freeBlocks[FREELIST_INDEX(i)], 1);
+                    start_free = (char *)p;
+                    end_free = start_free + i;
+                    return chunk_alloc(size, nobjs); // 再试一次
+                }
+            }
+            end_free = nullptr; // in case of exception
+            start_free = (char *)malloc_alloc::allocate(bytes_to_get); // 第一级是否还有能力挽救
+        }
+        heap_size += bytes_to_get;
+        end_free = start_free + bytes_to_get;
+        add(counters.heapSize, bytes_to_get);
+        add(counters.chunkAllocs, 1);
+        counters.lastChunkBytes.store(bytes_to_get, std::memory_order_relaxed);
+        return chunk_alloc(size, nobjs);
+    }
+}
+
+// n已调整为ALIGN的整数倍，调用者已持有锁
+template <bool threads, int inst>
+void *default_alloc_template<threads, inst>::refill(size_t n)
+{
+    int nobjs = 20;
+    char *chunk = chunk_alloc(n, nobjs);
+    counters.seaBytes.store(end_free - start_free, std::memory_order_relaxed);
+    if (nobjs == 1)
+        return chunk;
+    add(counters.freeBlocks[FREELIST_INDEX(n)], nobjs - 1);
+
+    obj *volatile *my_free_list = free_list + FREELIST_INDEX(n);
+    obj *result = (obj *)chunk;
+    obj *next_obj = (obj *)(chunk + n);
+    *my_free_list = next_obj;
+    for (int i = 1;; ++i)
+    {
+        obj *current_obj = next_obj;
+        next_obj = (obj *)((char *)current_obj + n);
+        if (nobjs - 1 == i)
+        {
+            current_obj->free_list_link = nullptr;
+            break;
+        }
+        current_obj->free_list_link = next_obj;
+    }
+    return result;
+}
+
+typedef default_alloc_template<true, 0> alloc;
+typedef default_alloc_template<false, 0> single_client_alloc;
+
+// ==================== 标准Allocator接口 ====================
+// 无状态，所有StdAlloc<T, Alloc>共用Alloc的static free list，因此任意两个实例都相等
+// 对齐要求超过ALIGN的类型直接交给一级配置器（malloc保证alignof(max_align_t)）
+template <typename T, typename Alloc = alloc>
+class StdAlloc
+{
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef StdAlloc<U, Alloc> other;
+    };
+
+    StdAlloc() noexcept {}
+    template <typename U>
+    StdAlloc(const StdAlloc<U, Alloc> &) noexcept {}
+
+    T *allocate(size_t n)
+    {
+        if (n == 0)
+            return nullptr;
+        if (n > size_t(-1) / sizeof(T))
+            throw std::bad_alloc();
+        if (alignof(T) > ALIGN)
+            return static_cast<T *>(malloc_alloc::allocate(n * sizeof(T)));
+        return static_cast<T *>(Alloc::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n) noexcept
+    {
+        if (p == nullptr || n == 0)
+            return;
+        if (alignof(T) > ALIGN)
+            malloc_alloc::deallocate(p, n * sizeof(T));
+        else
+            Alloc::deallocate(p, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U, typename Alloc>
+bool operator==(const StdAlloc<T, Alloc> &, const StdAlloc<U, Alloc> &) noexcept { return true; }
+template <typename T, typename U, typename Alloc>
+bool operator!=(const StdAlloc<T, Alloc> &, const StdAlloc<U, Alloc> &) noexcept { return false; }
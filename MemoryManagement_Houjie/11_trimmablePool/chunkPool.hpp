@@ -0,0 +1,612 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#if defined(_WIN32) || defined(__linux__)
+#include <malloc.h>
+#endif
+#include "chunkProvider.hpp"
+
+// 调试模式：编译时定义POOL_DEBUG=1(例如CMake的target_compile_definitions)。
+// 为0时下面所有检查都不参与编译，池的布局和代码与没有调试模式时完全相同。
+#ifndef POOL_DEBUG
+#define POOL_DEBUG 0
+#endif
+
+#if POOL_DEBUG
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#if defined(__SANITIZE_ADDRESS__)
+#define POOL_HAS_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define POOL_HAS_ASAN 1
+#endif
+#endif
+#ifdef POOL_HAS_ASAN
+#include <sanitizer/asan_interface.h>
+#define POOL_POISON(p, n) ASAN_POISON_MEMORY_REGION(p, n)
+#define POOL_UNPOISON(p, n) ASAN_UNPOISON_MEMORY_REGION(p, n)
+#else
+#define POOL_POISON(p, n) ((void)(p), (void)(n))
+#define POOL_UNPOISON(p, n) ((void)(p), (void)(n))
+#endif
+#endif
+
+// 可以把空chunk还给系统的定长对象池
+// 3_perClassAllocator/4_perClassAllocator2/5_staticAllocator的池只有一条全局free list，
+// 一个空闲对象属于哪个chunk无从得知，所以chunk永远不能释放。这里改为：
+// 1. 每个chunk由若干个对齐的page组成，每个page开头存一个指向所属Chunk的指针，
+//    deallocate时把地址按page对齐就能O(1)找到chunk；
+// 2. 每个chunk有自己的free list和live计数，live降为0的chunk就可以整块归还系统；
+// 3. chunk大小可以随需求自适应(12_adaptiveChunkSize)：每次不得不要新chunk时翻倍，直到上限；
+//    有chunk变空(需求回落)时减半，直到下限。
+// chunk通过ChunkProvider向系统要(chunkProvider.hpp)，默认是posix_memalign，可以换成大页。
+// POOL_DEBUG=1时每个slot变为 [DebugHeader][对象][尾部canary]：
+// 1. DebugHeader记录分配序号和状态(LIVE/FREE)，释放FREE状态的对象就是double free；
+// 2. 尾部canary紧跟在对象的最后一个字节之后，释放时被改写说明越界写；
+// 3. 释放后对象被填成0xDD，再次分配时检查是否还是0xDD，不是说明释放后被写过；
+// 4. 在ASan下，空闲的对象和头尾保护区都被标记为poisoned，释放后的读写当场报错；
+// 5. 析构时报告仍然存活的对象(泄漏)。
+// 发现错误时调用DebugHandler，默认打印后abort()；handler返回时，double free和非法指针的释放被忽略。
+class ChunkPool
+{
+private:
+    struct obj
+    {
+        struct obj *next;
+    };
+
+    enum ChunkState
+    {
+        PARTIAL, // 有空位，也有活对象
+        FULL,    // 没有空位
+        EMPTY    // 没有活对象
+    };
+
+    struct Chunk
+    {
+        char *base;       // 第一个page的地址
+        size_t pages;     // page个数
+        size_t capacity;  // 可容纳的对象数
+        size_t bumped;    // 已经切出过的slot数，[bumped, capacity)从未使用过
+        size_t live;      // 正在使用的对象数
+        obj *freeList;    // 切出后又被归还的slot
+        ChunkState state;
+        Chunk *prev, *next;
+    };
+
+    // 双向链表，按状态挂chunk
+    struct ChunkList
+    {
+        Chunk *head = nullptr;
+        size_t count = 0;
+
+        void push(Chunk *c)
+        {
+            c->prev = nullptr;
+            c->next = head;
+            if (head)
+                head->prev = c;
+            head = c;
+            ++count;
+        }
+        void remove(Chunk *c)
+        {
+            if (c->prev)
+                c->prev->next = c->next;
+            else
+                head = c->next;
+            if (c->next)
+                c->next->prev = c->prev;
+            --count;
+        }
+    };
+
+public:
+    static const size_t MIN_PAGE_BYTES = 4096;
+
+    struct Stats
+    {
+        size_t chunks;         // 持有的chunk数
+        size_t emptyChunks;    // 其中完全空闲的chunk数
+        size_t liveObjects;    // 正在使用的对象数
+        size_t reservedBytes;  // 向系统要的总字节数
+        size_t releasedBytes;  // 累计还给系统的字节数
+        size_t chunkAllocs;    // 累计向系统要chunk的次数
+        size_t nextChunkBytes; // 下一次要chunk的大小
+    };
+
+#if POOL_DEBUG
+    // error: 错误描述；ptr: 用户指针；objSize: 池的对象大小
+    typedef void (*DebugHandler)(const char *error, const void *ptr, size_t objSize);
+
+    static void setDebugHandler(DebugHandler h) { debugHandler = h ? h : defaultDebugHandler; }
+#endif
+
+    // objSize/objAlign: 对象大小与对齐
+    // minObjsPerChunk/maxObjsPerChunk: 每个chunk容纳对象数的下限/上限(会向上取整到整page)，
+    // max为0或不大于min时chunk大小固定
+    // provider: chunk的来源，nullptr表示ChunkProvider::getDefault()
+    ChunkPool(size_t objSize, size_t objAlign = sizeof(void *), size_t minObjsPerChunk = 0, size_t maxObjsPerChunk = 0,
+              ChunkProvider *provider = nullptr)
+        : provider(provider ? provider : ChunkProvider::getDefault())
+    {
+        if (objAlign < sizeof(void *))
+            objAlign = sizeof(void *);
+        if (objSize < sizeof(obj))
+            objSize = sizeof(obj);
+#if POOL_DEBUG
+        userSize = objSize;
+        frontBytes = (sizeof(DebugHeader) + objAlign - 1) / objAlign * objAlign;
+        slotSize = frontBytes + (objSize + sizeof(uint64_t) + objAlign - 1) / objAlign * objAlign;
+#else
+        slotSize = (objSize + objAlign - 1) / objAlign * objAlign;
+#endif
+        headerSize = (sizeof(Chunk *) + objAlign - 1) / objAlign * objAlign;
+        // page至少能放16个对象，保证page头的开销不超过1/16
+        pageBytes = MIN_PAGE_BYTES;
+        while (pageBytes < headerSize + 16 * slotSize)
+            pageBytes *= 2;
+        perPage = (pageBytes - headerSize) / slotSize;
+        minPages = minObjsPerChunk ? (minObjsPerChunk + perPage - 1) / perPage : 1;
+        maxPages = maxObjsPerChunk ? (maxObjsPerChunk + perPage - 1) / perPage : minPages;
+        if (maxPages < minPages)
+            maxPages = minPages;
+        nextPages = minPages;
+    }
+
+    ~ChunkPool()
+    {
+        // 池通常是类的静态成员，析构发生在程序退出时，只释放完全空闲的chunk，
+        // 仍有活对象的chunk留给操作系统回收，避免悬空指针
+#if POOL_DEBUG
+        reportLeaks();
+#endif
+        trim();
+    }
+
+    ChunkPool(const ChunkPool &) = delete;
+    ChunkPool &operator=(const ChunkPool &) = delete;
+
+    void *allocate()
+    {
+        Chunk *c = partial.head;
+        if (!c)
+        {
+            c = empty.head;
+            if (c)
+                empty.remove(c);
+            else
+                c = newChunk();
+            c->state = PARTIAL;
+            partial.push(c);
+        }
+
+        void *p;
+        if (c->freeList)
+        {
+            p = c->freeList;
+#if POOL_DEBUG
+            c->freeList = popChecked(c->freeList);
+#else
+            c->freeList = c->freeList->next;
+#endif
+        }
+        else
+            p = slotAddress(c, c->bumped++);
+#if POOL_DEBUG
+        markLive(p);
+#endif
+
+        ++liveTotal;
+        if (++c->live == c->capacity)
+        {
+            partial.remove(c);
+            c->state = FULL;
+            full.push(c);
+        }
+        return p;
+    }
+
+    void deallocate(void *ptr)
+    {
+        if (!ptr)
+            return;
+#if POOL_DEBUG
+        if (!markFree(ptr))
+            return;
+#endif
+        Chunk *c = chunkOf(ptr);
+        obj *p = static_cast<obj *>(ptr);
+        p->next = c->freeList;
+        c->freeList = p;
+#if POOL_DEBUG
+        linkFree(p);
+#endif
+        --liveTotal;
+
+        if (c->state == FULL)
+        {
+            full.remove(c);
+            c->state = PARTIAL;
+            partial.push(c);
+        }
+        if (--c->live == 0)
+        {
+            partial.remove(c);
+            c->state = EMPTY;
+            empty.push(c);
+            shrink();
+            if (autoRelease && empty.count > keepEmpty)
+                autoReleaseChunk();
+        }
+    }
+
+    // 一次分配n个对象，写入out[0, n)。每个chunk只做一次状态切换和计数更新：
+    // 先取完它的free list，再从未切过的区域连续切出，所以新chunk上得到的对象在地址上是连续的
+    // 要新chunk时provider可能抛出bad_alloc：此前取到的对象已经写在out的前面并计入live，其余位置不动
+    void allocate_n(void **out, size_t n)
+    {
+#if POOL_DEBUG
+        for (size_t i = 0; i < n; ++i)
+            out[i] = allocate();
+#else
+        while (n)
+        {
+            Chunk *c = partial.head;
+            if (!c)
+            {
+                c = empty.head;
+                if (c)
+                    empty.remove(c);
+                else
+                    c = newChunk();
+                c->state = PARTIAL;
+                partial.push(c);
+            }
+
+            size_t take = c->capacity - c->live < n ? c->capacity - c->live : n;
+            size_t i = 0;
+            obj *f = c->freeList;
+            for (; i < take && f; ++i)
+            {
+                out[i] = f;
+                f = f->next;
+            }
+            c->freeList = f;
+            for (; i < take; ++i)
+                out[i] = slotAddress(c, c->bumped++);
+
+            c->live += take;
+            liveTotal += take;
+            if (c->live == c->capacity)
+            {
+                partial.remove(c);
+                c->state = FULL;
+                full.push(c);
+            }
+            out += take;
+            n -= take;
+        }
+#endif
+    }
+
+    // 一次释放n个对象。相邻的、属于同一个chunk的对象先在本地串成一段，整段接到chunk的free list上
+    void deallocate_n(void **ptrs, size_t n)
+    {
+#if POOL_DEBUG
+        for (size_t i = 0; i < n; ++i)
+            deallocate(ptrs[i]);
+#else
+        size_t i = 0;
+        while (i < n)
+        {
+            if (!ptrs[i])
+            {
+                ++i;
+                continue;
+            }
+            Chunk *c = chunkOf(ptrs[i]);
+            obj *first = static_cast<obj *>(ptrs[i]);
+            obj *last = first;
+            size_t count = 1;
+            for (++i; i < n && ptrs[i] && chunkOf(ptrs[i]) == c; ++i, ++count)
+            {
+                obj *p = static_cast<obj *>(ptrs[i]);
+                last->next = p;
+                last = p;
+            }
+            last->next = c->freeList;
+            c->freeList = first;
+            liveTotal -= count;
+
+            if (c->state == FULL)
+            {
+                full.remove(c);
+                c->state = PARTIAL;
+                partial.push(c);
+            }
+            c->live -= count;
+            if (c->live == 0)
+            {
+                partial.remove(c);
+                c->state = EMPTY;
+                empty.push(c);
+                shrink();
+                if (autoRelease && empty.count > keepEmpty)
+                    autoReleaseChunk();
+            }
+        }
+#endif
+    }
+
+    // 把空chunk还给系统，最多保留keep个以应对下一次突发，返回释放的字节数
+    size_t trim(size_t keep = 0)
+    {
+        size_t bytes = 0;
+        while (empty.count > keep)
+            bytes += releaseChunk(empty.head);
+#if defined(__GLIBC__)
+        // 小于mmap阈值的chunk是从brk堆上拿的，需要malloc_trim才能真正降低RSS
+        if (bytes || untrimmedBytes)
+            malloc_trim(0);
+#endif
+        untrimmedBytes = 0;
+        return bytes;
+    }
+
+    // 自动释放策略：空chunk数超过keep时，多出来的立即还给malloc；
+    // 累计还了trimBytes字节才调用一次malloc_trim，把brk堆顶空出来的内存真正还给系统
+    void setAutoRelease(bool on, size_t keep = 1, size_t trimBytes = 1 << 20)
+    {
+        autoRelease = on;
+        keepEmpty = keep;
+        autoTrimBytes = trimBytes;
+        if (on)
+            trim(keep);
+    }
+
+    Stats stats() const
+    {
+        size_t n = partial.count + full.count + empty.count;
+        return Stats{n, empty.count, liveTotal, reservedBytes, releasedBytes, chunkAllocs, nextPages * pageBytes};
+    }
+
+#if POOL_DEBUG
+    size_t objectSize() const { return userSize; }
+#else
+    size_t objectSize() const { return slotSize; }
+#endif
+    size_t pageSize() const { return pageBytes; }
+    size_t minChunkBytes() const { return minPages * pageBytes; }
+    ChunkProvider *chunkProvider() const { return provider; }
+    size_t maxChunkBytes() const { return maxPages * pageBytes; }
+
+private:
+    void *slotAddress(Chunk *c, size_t i) const
+    {
+#if POOL_DEBUG
+        return c->base + (i / perPage) * pageBytes + headerSize + (i % perPage) * slotSize + frontBytes;
+#else
+        return c->base + (i / perPage) * pageBytes + headerSize + (i % perPage) * slotSize;
+#endif
+    }
+
+    Chunk *chunkOf(void *p) const
+    {
+        char *page = reinterpret_cast<char *>(reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(pageBytes - 1));
+        return *reinterpret_cast<Chunk **>(page);
+    }
+
+    // 所有已有chunk都满了才会走到这里，说明需求在增长：用完这次的大小后翻倍
+    Chunk *newChunk()
+    {
+        size_t pages = nextPages;
+        size_t bytes = pages * pageBytes;
+        char *base = static_cast<char *>(provider->allocate(bytes, pageBytes));
+        Chunk *c = new Chunk{base, pages, pages * perPage, 0, 0, nullptr, PARTIAL, nullptr, nullptr};
+        for (size_t i = 0; i < pages; ++i)
+        {
+            *reinterpret_cast<Chunk **>(base + i * pageBytes) = c;
+#if POOL_DEBUG
+            POOL_POISON(base + i * pageBytes + headerSize, pageBytes - headerSize); // 还没切出的slot
+#endif
+        }
+        reservedBytes += bytes;
+        ++chunkAllocs;
+        nextPages = pages * 2 < maxPages ? pages * 2 : maxPages;
+        return c;
+    }
+
+    // 有chunk整个空出来，说明需求在回落：下一次要的chunk减半
+    void shrink()
+    {
+        nextPages = nextPages / 2 > minPages ? nextPages / 2 : minPages;
+    }
+
+    // deallocate中的自动释放：malloc_trim要遍历整个堆并做madvise/brk系统调用，不能每还一个chunk都做一次，
+    // 按累计释放的字节数限频，一次trim的开销分摊到autoTrimBytes字节上
+    void autoReleaseChunk()
+    {
+        untrimmedBytes += releaseChunk(empty.head);
+#if defined(__GLIBC__)
+        if (untrimmedBytes >= autoTrimBytes)
+        {
+            malloc_trim(0);
+            untrimmedBytes = 0;
+        }
+#endif
+    }
+
+    size_t releaseChunk(Chunk *c)
+    {
+        size_t bytes = c->pages * pageBytes;
+        empty.remove(c);
+#if POOL_DEBUG
+        POOL_UNPOISON(c->base, bytes);
+#endif
+        provider->deallocate(c->base, bytes, pageBytes);
+        delete c;
+        reservedBytes -= bytes;
+        releasedBytes += bytes;
+        return bytes;
+    }
+
+#if POOL_DEBUG
+    struct DebugHeader
+    {
+        uint64_t serial; // 第几次分配，泄漏报告中用来定位；空闲时存放next的副本
+        uint64_t state;  // LIVE_MAGIC/FREE_MAGIC，紧挨着对象，向前越界写会先破坏它
+    };
+
+    static constexpr uint64_t LIVE_MAGIC = 0xA110CA7EDA110CA7ull;
+    static constexpr uint64_t FREE_MAGIC = 0xF4EEF4EEF4EEF4EEull;
+    static constexpr uint64_t REAR_CANARY = 0xCAFEBABEDEADBEEFull;
+    static constexpr unsigned char ALLOC_FILL = 0xCD; // 刚分配、还没构造的对象
+    static constexpr unsigned char FREE_FILL = 0xDD;  // 已释放的对象
+
+    static void defaultDebugHandler(const char *error, const void *ptr, size_t objSize)
+    {
+        fprintf(stderr, "ChunkPool<%zu>: %s at %p\n", objSize, error, ptr);
+        abort();
+    }
+
+    DebugHeader *headerOf(void *p) const
+    {
+        return reinterpret_cast<DebugHeader *>(static_cast<char *>(p) - sizeof(DebugHeader));
+    }
+
+    // 整个slot(含头尾保护区)，检查期间临时取消poison
+    char *slotOf(void *p) const { return static_cast<char *>(p) - frontBytes; }
+
+    // 对象之后到slot末尾都是保护区，canary放在最前面，不要求对齐
+    void writeCanary(void *p) const { memcpy(static_cast<char *>(p) + userSize, &REAR_CANARY, sizeof(uint64_t)); }
+    bool canaryIntact(void *p) const
+    {
+        uint64_t v;
+        memcpy(&v, static_cast<char *>(p) + userSize, sizeof(uint64_t));
+        return v == REAR_CANARY;
+    }
+
+    // 释放时：在头部存一份next，整个slot标记为poisoned
+    void linkFree(obj *p)
+    {
+        headerOf(p)->serial = reinterpret_cast<uintptr_t>(p->next);
+        POOL_POISON(slotOf(p), slotSize);
+    }
+
+    // 再次分配时：对象应当还是next加上一片0xDD，否则说明释放后被写过。
+    // next以头部的副本为准，悬空指针写坏了它也不会把free list带到别处
+    obj *popChecked(obj *p) const
+    {
+        POOL_UNPOISON(slotOf(p), slotSize);
+        obj *next = reinterpret_cast<obj *>(static_cast<uintptr_t>(headerOf(p)->serial));
+        const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+        bool intact = p->next == next;
+        for (size_t i = sizeof(obj); i < userSize && intact; ++i)
+            intact = b[i] == FREE_FILL;
+        if (!intact)
+            debugHandler("write after free", p, userSize);
+        return next;
+    }
+
+    void markLive(void *p)
+    {
+        POOL_UNPOISON(slotOf(p), slotSize);
+        DebugHeader *h = headerOf(p);
+        h->serial = ++allocSerial;
+        h->state = LIVE_MAGIC;
+        writeCanary(p);
+        memset(p, ALLOC_FILL, userSize);
+        POOL_POISON(slotOf(p), frontBytes);
+        POOL_POISON(static_cast<char *>(p) + userSize, slotSize - frontBytes - userSize);
+    }
+
+    bool ownsChunk(Chunk *c) const
+    {
+        for (const ChunkList *l : {&partial, &full, &empty})
+            for (Chunk *x = l->head; x; x = x->next)
+                if (x == c)
+                    return true;
+        return false;
+    }
+
+    // 返回false表示这次释放应当忽略
+    bool markFree(void *ptr)
+    {
+        char *page = reinterpret_cast<char *>(reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t)(pageBytes - 1));
+        size_t offset = static_cast<char *>(ptr) - page;
+        Chunk *c = chunkOf(ptr);
+        if (!ownsChunk(c) || offset < headerSize + frontBytes || (offset - headerSize - frontBytes) % slotSize != 0 ||
+            (offset - headerSize - frontBytes) / slotSize >= perPage)
+        {
+            debugHandler("free of a pointer not allocated by this pool", ptr, userSize);
+            return false;
+        }
+        POOL_UNPOISON(slotOf(ptr), slotSize);
+        DebugHeader *h = headerOf(ptr);
+        if (h->state != LIVE_MAGIC)
+        {
+            debugHandler(h->state == FREE_MAGIC ? "double free" : "header overwritten (buffer underflow?)", ptr, userSize);
+            POOL_POISON(slotOf(ptr), slotSize);
+            return false;
+        }
+        if (!canaryIntact(ptr))
+            debugHandler("rear canary overwritten (buffer overflow)", ptr, userSize);
+        h->state = FREE_MAGIC;
+        memset(ptr, FREE_FILL, userSize);
+        return true;
+    }
+
+    void reportLeaks()
+    {
+        if (!liveTotal)
+            return;
+        fprintf(stderr, "ChunkPool<%zu>: %zu object(s) leaked\n", userSize, liveTotal);
+        size_t shown = 0;
+        for (const ChunkList *l : {&partial, &full})
+            for (Chunk *c = l->head; c; c = c->next)
+                for (size_t i = 0; i < c->bumped && shown < 16; ++i)
+                {
+                    void *p = slotAddress(c, i);
+                    DebugHeader *h = headerOf(p);
+                    POOL_UNPOISON(h, sizeof(DebugHeader));
+                    bool live = h->state == LIVE_MAGIC;
+                    uint64_t serial = h->serial;
+                    POOL_POISON(h, sizeof(DebugHeader));
+                    if (live)
+                    {
+                        fprintf(stderr, "  %p allocation #%llu\n", p, (unsigned long long)serial);
+                        ++shown;
+                    }
+                }
+    }
+
+    static inline DebugHandler debugHandler = defaultDebugHandler;
+    size_t userSize;   // 对象大小(不含保护区)
+    size_t frontBytes; // slot开头到对象的距离，DebugHeader在对象紧前方
+    uint64_t allocSerial = 0;
+#endif
+
+private:
+    ChunkProvider *provider;
+    size_t slotSize;
+    size_t headerSize;    // 每个page开头的Chunk*（按对象对齐取整）
+    size_t pageBytes;     // 2的幂，page按它对齐
+    size_t perPage;       // 每个page的对象数
+    size_t minPages;      // chunk大小的下限(page数)
+    size_t maxPages;      // chunk大小的上限(page数)
+    size_t nextPages;     // 下一次要的chunk大小(page数)
+    ChunkList partial, full, empty;
+    size_t liveTotal = 0;
+    size_t reservedBytes = 0;
+    size_t releasedBytes = 0;
+    size_t chunkAllocs = 0;
+    bool autoRelease = false;
+    size_t keepEmpty = 1;
+    size_t autoTrimBytes = 1 << 20; // 自动释放累计到这么多字节才malloc_trim一次
+    size_t untrimmedBytes = 0;      // 上次malloc_trim之后自动释放的字节数
+};
@@ -0,0 +1,180 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#if defined(_WIN32) || defined(__linux__)
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// 池向系统要chunk的那一层
+// ChunkPool原来直接调用posix_memalign，现在通过ChunkProvider要、还chunk，可以换成别的来源，
+// 例如HugePageChunkProvider。chunk的分配只发生在池的慢路径上，虚函数调用的开销可以忽略。
+class ChunkProvider
+{
+public:
+    // 按align(2的幂)对齐的bytes字节，失败时抛出bad_alloc
+    virtual void *allocate(size_t bytes, size_t align) = 0;
+    // bytes、align必须与allocate时相同
+    virtual void deallocate(void *p, size_t bytes, size_t align) = 0;
+    virtual const char *name() const = 0;
+
+    // 没有指定provider的池使用的默认provider，初始是MallocChunkProvider。
+    // 只影响之后构造的池，所以要在第一个池构造之前设置
+    static ChunkProvider *getDefault() { return defaultSlot(); }
+    static void setDefault(ChunkProvider *p) { defaultSlot() = p ? p : fallback(); }
+
+protected:
+    constexpr ChunkProvider() {}
+    ~ChunkProvider() = default; // provider通常是全局对象，不会通过基类指针delete
+
+    static ChunkProvider *fallback();
+
+private:
+    static ChunkProvider *&defaultSlot()
+    {
+        static ChunkProvider *p = fallback();
+        return p;
+    }
+};
+
+// posix_memalign(Windows下_aligned_malloc)，即ChunkPool原来的做法
+class MallocChunkProvider : public ChunkProvider
+{
+public:
+    constexpr MallocChunkProvider() {}
+
+    void *allocate(size_t bytes, size_t align) override
+    {
+#ifdef _WIN32
+        void *p = _aligned_malloc(bytes, align);
+#else
+        void *p = nullptr;
+        if (posix_memalign(&p, align, bytes) != 0)
+            p = nullptr;
+#endif
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    void deallocate(void *p, size_t, size_t) override
+    {
+#ifdef _WIN32
+        _aligned_free(p);
+#else
+        free(p);
+#endif
+    }
+
+    const char *name() const override { return "malloc"; }
+};
+
+// 常量初始化，没有析构，程序退出时静态的池析构也能安全地使用它
+inline MallocChunkProvider mallocChunkProvider;
+
+inline ChunkProvider *ChunkProvider::fallback() { return &mallocChunkProvider; }
+
+// 用2MB的大页提供chunk，减少大量对象分散在几百MB内存中时的TLB miss
+// 1. EXPLICIT：先尝试mmap(MAP_HUGETLB)，需要管理员预留大页(/proc/sys/vm/nr_hugepages)，
+//    没有预留时mmap失败，退到2；
+// 2. TRANSPARENT：普通mmap，按2MB对齐后madvise(MADV_HUGEPAGE)，请内核用透明大页(THP)。
+//    THP被禁用(never)时madvise失败，内存仍然可用，只是还是4KB的页；
+// 3. 小于minBytes(默认2MB)的chunk用大页会浪费，交给MallocChunkProvider。
+// chunk大小按2MB向上取整，所以池的chunk最好是2MB的整数倍；非Linux平台全部交给MallocChunkProvider。
+class HugePageChunkProvider : public ChunkProvider
+{
+public:
+    static const size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+    enum Mode
+    {
+        EXPLICIT,   // MAP_HUGETLB，失败时用THP
+        TRANSPARENT // 只用THP
+    };
+
+    struct Stats
+    {
+        size_t hugetlbChunks; // 来自MAP_HUGETLB的chunk数
+        size_t thpChunks;     // 来自mmap + MADV_HUGEPAGE的chunk数
+        size_t smallChunks;   // 小于minBytes、交给malloc的chunk数
+        size_t madviseFailures;
+    };
+
+    explicit HugePageChunkProvider(Mode mode = EXPLICIT, size_t minBytes = HUGE_PAGE) : mode(mode), minBytes(minBytes) {}
+
+    void *allocate(size_t bytes, size_t align) override
+    {
+#ifdef __linux__
+        if (bytes >= minBytes && align <= HUGE_PAGE)
+        {
+            size_t len = roundUp(bytes);
+#ifdef MAP_HUGETLB
+            if (mode == EXPLICIT)
+            {
+                void *p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (p != MAP_FAILED)
+                {
+                    hugetlbChunks.fetch_add(1, std::memory_order_relaxed);
+                    return p;
+                }
+            }
+#endif
+            // 多要2MB，把首尾多出的部分还回去，剩下的按2MB对齐，THP才能用大页映射
+            char *raw = static_cast<char *>(mmap(nullptr, len + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (raw == MAP_FAILED)
+                throw std::bad_alloc();
+            char *p = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(raw) + HUGE_PAGE - 1) & ~uintptr_t(HUGE_PAGE - 1));
+            if (p != raw)
+                munmap(raw, p - raw);
+            if (size_t tail = raw + len + HUGE_PAGE - (p + len))
+                munmap(p + len, tail);
+#ifdef MADV_HUGEPAGE
+            if (madvise(p, len, MADV_HUGEPAGE) != 0)
+                madviseFailures.fetch_add(1, std::memory_order_relaxed);
+#else
+            madviseFailures.fetch_add(1, std::memory_order_relaxed);
+#endif
+            thpChunks.fetch_add(1, std::memory_order_relaxed);
+            return p;
+        }
+#endif
+        smallChunks.fetch_add(1, std::memory_order_relaxed);
+        return mallocChunkProvider.allocate(bytes, align);
+    }
+
+    void deallocate(void *p, size_t bytes, size_t align) override
+    {
+#ifdef __linux__
+        // MAP_HUGETLB和THP的映射长度都是roundUp(bytes)，munmap的方式相同
+        if (bytes >= minBytes && align <= HUGE_PAGE)
+        {
+            munmap(p, roundUp(bytes));
+            return;
+        }
+#endif
+        mallocChunkProvider.deallocate(p, bytes, align);
+    }
+
+    const char *name() const override { return mode == EXPLICIT ? "hugetlb" : "thp"; }
+
+    Stats stats() const
+    {
+        return Stats{hugetlbChunks.load(std::memory_order_relaxed), thpChunks.load(std::memory_order_relaxed),
+                     smallChunks.load(std::memory_order_relaxed), madviseFailures.load(std::memory_order_relaxed)};
+    }
+
+private:
+    static size_t roundUp(size_t n) { return (n + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE; }
+
+    Mode mode;
+    size_t minBytes;
+    std::atomic<size_t> hugetlbChunks{0};
+    std::atomic<size_t> thpChunks{0};
+    std::atomic<size_t> smallChunks{0};
+    std::atomic<size_t> madviseFailures{0};
+};
@@ -0,0 +1,190 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "chunkPool.hpp"
+#include "rss.hpp"
+using namespace std;
+
+void printStats(const string &name, const ChunkPool &pool)
+{
+    ChunkPool::Stats s = pool.stats();
+    cout << name << ": chunks = " << s.chunks << ", empty = " << s.emptyChunks
+         << ", live = " << s.liveObjects << ", reserved = " << s.reservedBytes / 1024 << " KB"
+         << ", released = " << s.releasedBytes / 1024 << " KB, RSS = " << rssKB() << " KB" << endl;
+}
+
+// 三个类的chunk大小上限，与12_adaptiveChunkSize相同
+const size_t MAX_OBJS_PER_CHUNK = 65536;
+
+// 3_perClassAllocator的Screen：不再需要next成员，free list由池管理
+class Screen
+{
+public:
+    Screen(int x) : id(x) {}
+    int get() { return id; }
+
+    void *operator new(size_t size)
+    {
+        return pool.allocate();
+    }
+    void operator delete(void *ptr)
+    {
+        pool.deallocate(ptr);
+    }
+
+    static ChunkPool pool;
+
+private:
+    int id;
+};
+
+// 每个chunk至少24个对象，需求增长时翻倍(见12_adaptiveChunkSize)，最多MAX_OBJS_PER_CHUNK个
+ChunkPool Screen::pool(sizeof(Screen), alignof(Screen), 24, MAX_OBJS_PER_CHUNK);
+
+// 4_perClassAllocator2的Airplane：池的free list在对象外部，union也不再需要
+class Airplane
+{
+private:
+    struct AirplaneRep
+    {
+        unsigned long miles;
+        char type;
+    };
+    AirplaneRep rep;
+
+public:
+    unsigned long getMiles() const { return rep.miles; }
+    char getType() const { return rep.type; }
+    void set(unsigned long m, char t)
+    {
+        rep.miles = m;
+        rep.type = t;
+    }
+
+public:
+    static void *operator new(size_t size)
+    {
+        if (size != sizeof(Airplane))
+            return ::operator new(size);
+        return pool.allocate();
+    }
+    static void operator delete(void *deadObject, size_t size)
+    {
+        if (deadObject == nullptr)
+            return;
+        if (size != sizeof(Airplane))
+        {
+            ::operator delete(deadObject);
+            return;
+        }
+        pool.deallocate(deadObject);
+    }
+
+    static ChunkPool pool;
+};
+
+ChunkPool Airplane::pool(sizeof(Airplane), alignof(Airplane), 512, MAX_OBJS_PER_CHUNK);
+
+// 5_staticAllocator的Allocator：接口不变，对象大小在第一次allocate时确定，底层换成ChunkPool
+class Allocator
+{
+public:
+    ~Allocator() { delete pool; }
+
+    void *allocate(size_t size)
+    {
+        if (!pool)
+            pool = new ChunkPool(size, sizeof(void *), CHUNK, MAX_OBJS_PER_CHUNK);
+        return pool->allocate();
+    }
+    void deallocate(void *ptr, size_t size)
+    {
+        pool->deallocate(ptr);
+    }
+    size_t trim(size_t keep = 0) { return pool ? pool->trim(keep) : 0; }
+    void setAutoRelease(bool on, size_t keep = 1, size_t trimBytes = 1 << 20)
+    {
+        if (pool)
+            pool->setAutoRelease(on, keep, trimBytes);
+    }
+    const ChunkPool *getPool() const { return pool; }
+
+private:
+    ChunkPool *pool = nullptr;
+    const int CHUNK = 5;
+};
+
+class Foo
+{
+public:
+    long L;
+    string str;
+    static Allocator alloc;
+
+public:
+    Foo(long l, const string &s) : L(l), str(s) {}
+    static void *operator new(size_t size)
+    {
+        return alloc.allocate(size);
+    }
+    static void operator delete(void *ptr, size_t size)
+    {
+        alloc.deallocate(ptr, size);
+    }
+};
+
+Allocator Foo::alloc;
+
+int main()
+{
+    // 1. 与3_perClassAllocator相同的输出，地址依然连续
+    {
+        Screen *p[8];
+        cout << "sizeof(Screen) = " << sizeof(Screen) << endl;
+        for (int i = 0; i < 8; ++i)
+            p[i] = new Screen(i);
+        for (int i = 0; i < 8; ++i)
+            cout << p[i] << " " << p[i]->get() << endl;
+        for (int i = 0; i < 8; ++i)
+            delete p[i];
+        printStats("Screen", Screen::pool);
+    }
+
+    // 2. 突发流量：一次创建200万个Airplane，全部删除后再trim
+    {
+        const size_t N = 2000000;
+        cout << "\nRSS before burst = " << rssKB() << " KB" << endl;
+        vector<Airplane *> v(N);
+        for (size_t i = 0; i < N; ++i)
+        {
+            v[i] = new Airplane;
+            v[i]->set(i, 'A');
+        }
+        printStats("Airplane after new", Airplane::pool);
+        for (size_t i = 0; i < N; ++i)
+            delete v[i];
+        vector<Airplane *>().swap(v);
+        printStats("Airplane after delete", Airplane::pool);
+        size_t released = Airplane::pool.trim(1);
+        cout << "trim(1) released " << released / 1024 << " KB" << endl;
+        printStats("Airplane after trim", Airplane::pool);
+    }
+
+    // 3. 自动释放：空chunk超过1个就立即还给系统
+    {
+        const size_t N = 200000;
+        vector<Foo *> v(N);
+        for (size_t i = 0; i < N; ++i)
+            v[i] = new Foo(long(i), "hello");
+        Foo::alloc.setAutoRelease(true, 1);
+        printStats("\nFoo after new", *Foo::alloc.getPool());
+        // 只删除一半(下标为偶数的)，且是隔一个删一个：chunk都还有活对象，一个也不能释放
+        for (size_t i = 0; i < N; i += 2)
+            delete v[i];
+        printStats("Foo after deleting even", *Foo::alloc.getPool());
+        for (size_t i = 1; i < N; i += 2)
+            delete v[i];
+        printStats("Foo after deleting all", *Foo::alloc.getPool());
+    }
+    return 0;
+}
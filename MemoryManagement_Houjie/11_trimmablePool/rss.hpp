@@ -0,0 +1,19 @@
+#pragma once
+#include <fstream>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+// 当前进程的常驻内存(KB)，仅Linux下可用，其他平台返回0
+// statm的第二项是常驻的页数，页大小不一定是4KB(有的内核是16KB、64KB)，按sysconf换算
+inline long rssKB()
+{
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return 0;
+#endif
+}
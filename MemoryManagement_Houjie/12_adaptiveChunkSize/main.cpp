@@ -0,0 +1,132 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "../11_trimmablePool/chunkPool.hpp"
+using namespace std;
+
+// 5_staticAllocator的Allocator，只加了一个malloc计数
+class Allocator
+{
+private:
+    struct obj
+    {
+        struct obj *next;
+    };
+
+public:
+    void *allocate(size_t size)
+    {
+        obj *p;
+        if (!freeStore)
+        {
+            size_t chunk = CHUNK * size;
+            freeStore = p = (obj *)malloc(chunk);
+            ++mallocCount;
+            for (int i = 0; i < CHUNK - 1; ++i)
+            {
+                p->next = (obj *)((char *)p + size);
+                p = p->next;
+            }
+            p->next = nullptr;
+        }
+        p = freeStore;
+        freeStore = freeStore->next;
+        return p;
+    }
+    void deallocate(void *ptr, size_t size)
+    {
+        ((obj *)ptr)->next = freeStore;
+        freeStore = (obj *)ptr;
+    }
+
+    size_t mallocCount = 0;
+
+private:
+    obj *freeStore = nullptr;
+    const int CHUNK = 5;
+};
+
+// Foo的三个版本：原始Allocator、固定chunk的ChunkPool、自适应chunk的ChunkPool
+struct FooData
+{
+    long L;
+    string str;
+    FooData(long l, const string &s) : L(l), str(s) {}
+};
+
+class FooOrigin : public FooData
+{
+public:
+    using FooData::FooData;
+    static Allocator alloc;
+    static void *operator new(size_t size) { return alloc.allocate(size); }
+    static void operator delete(void *ptr, size_t size) { alloc.deallocate(ptr, size); }
+};
+Allocator FooOrigin::alloc;
+
+class FooFixed : public FooData
+{
+public:
+    using FooData::FooData;
+    static ChunkPool pool;
+    static void *operator new(size_t) { return pool.allocate(); }
+    static void operator delete(void *ptr) { pool.deallocate(ptr); }
+};
+// 上下限相同，chunk大小固定为1个page
+ChunkPool FooFixed::pool(sizeof(FooFixed), alignof(FooFixed), 5);
+
+class FooAdaptive : public FooData
+{
+public:
+    using FooData::FooData;
+    static ChunkPool pool;
+    static void *operator new(size_t) { return pool.allocate(); }
+    static void operator delete(void *ptr) { pool.deallocate(ptr); }
+};
+// 从1个page开始翻倍，上限为65536个对象(约2.6MB)
+ChunkPool FooAdaptive::pool(sizeof(FooAdaptive), alignof(FooAdaptive), 5, 65536);
+
+// 分配N个对象后打印一次统计(此时的nextChunk反映需求增长到了多大)，再全部释放
+template <typename T>
+void burst(const string &name, size_t N, const ChunkPool *pool)
+{
+    vector<T *> v(N);
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < N; ++i)
+        v[i] = new T(long(i), "hello");
+    chrono::duration<double, milli> d = chrono::steady_clock::now() - start;
+
+    cout << left << setw(14) << name << right;
+    if (pool)
+    {
+        ChunkPool::Stats s = pool->stats();
+        cout << setw(10) << s.chunkAllocs << setw(12) << s.reservedBytes / 1024 << setw(14) << s.nextChunkBytes;
+    }
+    else
+        cout << setw(10) << FooOrigin::alloc.mallocCount << setw(12) << FooOrigin::alloc.mallocCount * 5 * sizeof(T) / 1024
+             << setw(14) << 5 * sizeof(T);
+    cout << setw(10) << fixed << setprecision(1) << d.count() << endl;
+
+    for (size_t i = 0; i < N; ++i)
+        delete v[i];
+}
+
+int main()
+{
+    const size_t N = 1000000;
+    cout << "sizeof(Foo) = " << sizeof(FooData) << endl;
+    cout << left << setw(14) << "allocator" << right << setw(10) << "refills"
+         << setw(12) << "reservedKB" << setw(14) << "nextChunk(B)" << setw(10) << "new(ms)" << endl;
+
+    // 1. 需求增长：一次突发100万个对象
+    burst<FooOrigin>("Allocator", N, nullptr);
+    burst<FooFixed>("fixed", N, &FooFixed::pool);
+    burst<FooAdaptive>("adaptive", N, &FooAdaptive::pool);
+
+    // 2. 需求回落：上面释放时chunk逐个变空，nextChunk已经减半回到下限；trim后再来一次小突发
+    FooAdaptive::pool.trim();
+    burst<FooAdaptive>("adaptive(1k)", 1000, &FooAdaptive::pool);
+    return 0;
+}
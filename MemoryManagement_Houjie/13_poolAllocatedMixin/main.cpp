@@ -0,0 +1,219 @@
+#include <iostream>
+#include <string>
+#include <complex>
+#include <chrono>
+#include <vector>
+#include "poolAllocated.hpp"
+using namespace std;
+
+// 6_staticAllocatorMacro的写法，用来对照
+class Allocator
+{
+private:
+    struct obj
+    {
+        struct obj *next;
+    };
+
+public:
+    void *allocate(size_t size)
+    {
+        obj *p;
+        if (!freeStore)
+        {
+            size_t chunk = CHUNK * size;
+            freeStore = p = (obj *)malloc(chunk);
+            for (int i = 0; i < CHUNK - 1; ++i)
+            {
+                p->next = (obj *)((char *)p + size);
+                p = p->next;
+            }
+            p->next = nullptr;
+        }
+        p = freeStore;
+        freeStore = freeStore->next;
+        return p;
+    }
+    void deallocate(void *ptr, size_t size)
+    {
+        ((obj *)ptr)->next = freeStore;
+        freeStore = (obj *)ptr;
+    }
+
+private:
+    obj *freeStore = nullptr;
+    const int CHUNK = 5;
+};
+
+#define DECLARE_POOL_ALLOC()                                                      \
+public:                                                                           \
+    void *operator new(size_t size) { return alloc.allocate(size); }              \
+    void operator delete(void *ptr, size_t size) { alloc.deallocate(ptr, size); } \
+                                                                                  \
+protected:                                                                        \
+    static Allocator alloc;
+
+#define IMPLEMENT_POOL_ALLOC(className) Allocator className::alloc;
+
+class MacroFoo
+{
+    DECLARE_POOL_ALLOC()
+public:
+    long L;
+    string str;
+    MacroFoo(long l, const string &s) : L(l), str(s) {}
+    virtual ~MacroFoo() {}
+};
+IMPLEMENT_POOL_ALLOC(MacroFoo)
+
+// 派生类没有声明自己的池，悄悄地用了基类的alloc，而且对象更大
+class MacroFooEx : public MacroFoo
+{
+public:
+    double extra[4];
+    MacroFooEx(long l) : MacroFoo(l, "ex"), extra{} {}
+};
+
+// ==================== CRTP版本 ====================
+class Foo : public PoolAllocated<Foo>
+{
+public:
+    long L;
+    string str;
+    Foo(long l, const string &s) : L(l), str(s) {}
+    virtual ~Foo() {}
+};
+
+class Goo : public PoolAllocated<Goo, FixedChunk<256>>
+{
+public:
+    complex<double> c;
+    Goo(const complex<double> &x) : c(x) {}
+};
+
+// 把mixin插在FooEx和Foo之间，FooEx就有了自己的池
+class FooEx : public PoolAllocated<FooEx, GeometricChunk<16, 4096>, Foo>
+{
+public:
+    double extra[4];
+    FooEx(long l) : PoolAllocated(l, "ex"), extra{} {}
+};
+
+// 没有插mixin的派生类：size与sizeof(Foo)不符，转交给::operator new
+class FooPlain : public Foo
+{
+public:
+    double extra[4];
+    FooPlain(long l) : Foo(l, "plain"), extra{} {}
+};
+
+void printStats(const string &name, const ChunkPool::Stats &s)
+{
+    cout << name << " pool: live = " << s.liveObjects << ", chunks = " << s.chunks
+         << ", reserved = " << s.reservedBytes << " B" << endl;
+}
+
+template <typename T, typename... Args>
+double bench_ns(size_t N, Args... args)
+{
+    vector<T *> v(N);
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < 10; ++r)
+    {
+        for (size_t i = 0; i < N; ++i)
+            v[i] = new T(args...);
+        for (size_t i = 0; i < N; ++i)
+            delete v[i];
+    }
+    chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+    return d.count() / (20 * N);
+}
+
+// 与bench_ns相同的工作量，用new_n/delete_n一次处理N个
+template <typename T, typename... Args>
+double bench_batch_ns(size_t N, Args... args)
+{
+    vector<T *> v(N);
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < 10; ++r)
+    {
+        T::new_n(v.data(), N, args...);
+        T::delete_n(v.data(), N);
+    }
+    chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+    return d.count() / (20 * N);
+}
+
+int main()
+{
+    // 1. 宏版本：MacroFooEx继承了MacroFoo的operator new和alloc，
+    //    拿到的是按sizeof(MacroFoo)切好的块，真的在上面构造MacroFooEx就会写坏相邻的块，
+    //    所以这里只调用operator new看地址，不构造对象
+    {
+        cout << "sizeof(MacroFoo) = " << sizeof(MacroFoo) << ", sizeof(MacroFooEx) = " << sizeof(MacroFooEx) << endl;
+        MacroFoo *a = new MacroFoo(1, "a");
+        void *raw = MacroFooEx::operator new(sizeof(MacroFooEx));
+        MacroFoo *b = new MacroFoo(2, "b");
+        cout << "a = " << a << ", MacroFooEx raw = " << raw << ", b = " << b
+             << "  (只隔" << sizeof(MacroFoo) << "字节，装不下" << sizeof(MacroFooEx) << "字节的MacroFooEx)" << endl;
+        delete b;
+        MacroFooEx::operator delete(raw, sizeof(MacroFooEx));
+        delete a;
+    }
+
+    // 2. CRTP版本：每个类型一个按自身大小建立的池
+    {
+        cout << "\nsizeof(Foo) = " << sizeof(Foo) << ", sizeof(Goo) = " << sizeof(Goo)
+             << ", sizeof(FooEx) = " << sizeof(FooEx) << ", sizeof(FooPlain) = " << sizeof(FooPlain) << endl;
+        Foo *p[5];
+        FooEx *q[5];
+        for (int i = 0; i < 5; ++i)
+        {
+            p[i] = new Foo(i, "hello");
+            q[i] = new FooEx(i);
+        }
+        for (int i = 0; i < 5; ++i)
+            cout << p[i] << " " << q[i] << endl;
+        Goo *g = new Goo(complex<double>(1, 2));
+        Foo *plain = new FooPlain(9);
+        cout << "FooPlain (::operator new) = " << plain << endl;
+        printStats("Foo", Foo::poolStats());
+        printStats("FooEx", FooEx::poolStats());
+        printStats("Goo", Goo::poolStats());
+
+        delete plain;
+        delete g;
+        for (int i = 0; i < 5; ++i)
+        {
+            delete p[i];
+            delete q[i]; // 虚析构，sized delete拿到的是sizeof(FooEx)，回到FooEx的池
+        }
+        printStats("Foo", Foo::poolStats());
+        printStats("FooEx", FooEx::poolStats());
+    }
+
+    // 3. 快路径开销(ns/op)
+    {
+        const size_t N = 100000;
+        cout << "\nnew+delete (ns/op): Goo = " << bench_ns<Goo>(N, complex<double>(1, 1))
+             << ", complex<double> (::operator new) = " << bench_ns<complex<double>>(N, 1.0, 1.0) << endl;
+    }
+
+    // 4. 批量版本：new_n一次取一段free list或一段连续的slot，delete_n把同一chunk的对象整段挂回去
+    {
+        Foo *p[10];
+        Foo::new_n(p, 10, 7L, string("batch"));
+        cout << "\nFoo::new_n(10):";
+        for (Foo *f : p)
+            cout << " " << f;
+        cout << endl;
+        printStats("Foo", Foo::poolStats());
+        Foo::delete_n(p, 10);
+        printStats("Foo", Foo::poolStats());
+
+        const size_t N = 100000;
+        cout << "new_n+delete_n (ns/op): Goo = " << bench_batch_ns<Goo>(N, complex<double>(1, 1))
+             << ", loop of new+delete = " << bench_ns<Goo>(N, complex<double>(1, 1)) << endl;
+    }
+    return 0;
+}
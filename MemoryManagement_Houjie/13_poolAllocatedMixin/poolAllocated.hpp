@@ -0,0 +1,215 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+#include "../11_trimmablePool/chunkPool.hpp"
+
+// chunk大小策略：编译期常量，决定ChunkPool每个chunk容纳对象数的上下限，
+// 以及元素个数不超过maxArray的new T[n]从池中分配(14_pooledArrayNew)
+template <size_t N, size_t MaxArray = 8>
+struct FixedChunk
+{
+    static constexpr size_t minObjs = N;
+    static constexpr size_t maxObjs = N;
+    static constexpr size_t maxArray = MaxArray;
+};
+
+template <size_t Min, size_t Max, size_t MaxArray = 8>
+struct GeometricChunk
+{
+    static_assert(Min <= Max, "GeometricChunk: Min must not exceed Max");
+    static constexpr size_t minObjs = Min;
+    static constexpr size_t maxObjs = Max;
+    static constexpr size_t maxArray = MaxArray;
+};
+
+typedef GeometricChunk<64, 65536> DefaultChunkPolicy;
+
+// 没有基类时的占位
+struct PoolRoot
+{
+};
+
+// 用CRTP代替6_staticAllocatorMacro中的DECLARE_POOL_ALLOC/IMPLEMENT_POOL_ALLOC：
+//   class Foo : public PoolAllocated<Foo> { ... };
+// 1. 池按sizeof(T)/alignof(T)建立，不必等到第一次operator new才知道对象大小；
+// 2. 每个T有自己的池(函数内static)，不需要在类外写定义；
+// 3. 派生类若想要自己的池，把mixin插在它和基类之间：
+//   class FooEx : public PoolAllocated<FooEx, FixedChunk<5>, Foo> { ... };
+//   没有这样做的派生类，size与sizeof(T)不符，会转交给全局::operator new，不会误用基类的池。
+template <typename T, typename ChunkPolicy = DefaultChunkPolicy, typename Base = PoolRoot>
+class PoolAllocated : public Base
+{
+public:
+    using Base::Base;
+
+    static void *operator new(size_t size)
+    {
+        if (size != sizeof(T))
+            return ::operator new(size);
+        return pool().allocate();
+    }
+
+    static void operator delete(void *ptr, size_t size)
+    {
+        if (ptr == nullptr)
+            return;
+        if (size != sizeof(T))
+        {
+            ::operator delete(ptr);
+            return;
+        }
+        pool().deallocate(ptr);
+    }
+
+    // 数组版本：按总字节数(含编译器写入的元素个数cookie)分到以ARRAY_GRANULE为步长的size class池，
+    // 超过maxArray个元素的数组交给全局::operator new[]
+    static void *operator new[](size_t size)
+    {
+        if (size > maxArrayBytes())
+            return ::operator new[](size);
+        return arrayPool(size).allocate();
+    }
+
+    // 类中声明了带size的operator delete[]，编译器总会为数组保留cookie，这里拿到的size与new[]时相同
+    static void operator delete[](void *ptr, size_t size)
+    {
+        if (ptr == nullptr)
+            return;
+        if (size > maxArrayBytes())
+        {
+            ::operator delete[](ptr);
+            return;
+        }
+        arrayPool(size).deallocate(ptr);
+    }
+
+    // 批量版本：一次从池中取n个对象的内存，在上面构造T(args...)，写入out[0, n)。
+    // 新chunk上的对象地址连续，逐个构造的循环编译器可以展开、向量化。
+    // 某个构造函数或allocate_n(要新chunk时)抛出异常时，已构造的对象被析构，已取到的内存全部还回池中
+    template <typename... Args>
+    static void new_n(T **out, size_t n, const Args &...args)
+    {
+        const size_t BATCH = 64;
+        void *raw[BATCH];
+        size_t done = 0;
+        try
+        {
+            while (done < n)
+            {
+                size_t k = n - done < BATCH ? n - done : BATCH;
+                // allocate_n中途失败时只有前面一部分写入了raw，其余保持nullptr，deallocate_n会跳过
+                for (size_t j = 0; j < k; ++j)
+                    raw[j] = nullptr;
+                try
+                {
+                    pool().allocate_n(raw, k);
+                }
+                catch (...)
+                {
+                    pool().deallocate_n(raw, k);
+                    throw;
+                }
+                size_t i = 0;
+                try
+                {
+                    for (; i < k; ++i)
+                        out[done + i] = ::new (raw[i]) T(args...);
+                }
+                catch (...)
+                {
+                    pool().deallocate_n(raw + i, k - i);
+                    done += i;
+                    throw;
+                }
+                done += k;
+            }
+        }
+        catch (...)
+        {
+            delete_n(out, done);
+            throw;
+        }
+    }
+
+    // 析构out[0, n)并一次还给池；对象必须都是new_n(或new T)得到的、真实类型就是T
+    static void delete_n(T **objs, size_t n)
+    {
+        const size_t BATCH = 64;
+        void *raw[BATCH];
+        for (size_t done = 0; done < n;)
+        {
+            size_t k = n - done < BATCH ? n - done : BATCH;
+            for (size_t i = 0; i < k; ++i)
+            {
+                objs[done + i]->~T();
+                raw[i] = objs[done + i];
+            }
+            pool().deallocate_n(raw, k);
+            done += k;
+        }
+    }
+
+    static size_t trimPool(size_t keep = 0)
+    {
+        size_t bytes = pool().trim(keep);
+        for (auto &p : arrayPools())
+            if (p)
+                bytes += p->trim(keep);
+        return bytes;
+    }
+    static ChunkPool::Stats poolStats() { return pool().stats(); }
+    // 所有数组size class池的统计之和
+    static ChunkPool::Stats arrayPoolStats()
+    {
+        ChunkPool::Stats sum{};
+        for (auto &p : arrayPools())
+            if (p)
+            {
+                ChunkPool::Stats s = p->stats();
+                sum.chunks += s.chunks;
+                sum.emptyChunks += s.emptyChunks;
+                sum.liveObjects += s.liveObjects;
+                sum.reservedBytes += s.reservedBytes;
+                sum.releasedBytes += s.releasedBytes;
+                sum.chunkAllocs += s.chunkAllocs;
+            }
+        return sum;
+    }
+
+protected:
+    // 放在函数内，保证在任何静态对象的构造函数中new T也是安全的
+    static ChunkPool &pool()
+    {
+        static_assert(alignof(T) <= ChunkPool::MIN_PAGE_BYTES, "PoolAllocated: alignment too large");
+        static ChunkPool p(sizeof(T), alignof(T), ChunkPolicy::minObjs, ChunkPolicy::maxObjs);
+        return p;
+    }
+
+private:
+    // size class以ARRAY_GRANULE(一个cookie的大小)为步长，slot按max(alignof(T), ARRAY_GRANULE)对齐
+    // (类定义时T还不完整，不能在类内用sizeof(T)定义常量，所以写成函数)
+    static constexpr size_t ARRAY_GRANULE = sizeof(size_t);
+    static constexpr size_t arrayAlign() { return alignof(T) > ARRAY_GRANULE ? alignof(T) : ARRAY_GRANULE; }
+    // cookie占max(sizeof(size_t), alignof(T))字节
+    static constexpr size_t maxArrayBytes() { return ChunkPolicy::maxArray * sizeof(T) + arrayAlign(); }
+
+    static std::vector<std::unique_ptr<ChunkPool>> &arrayPools()
+    {
+        static std::vector<std::unique_ptr<ChunkPool>> pools(maxArrayBytes() / ARRAY_GRANULE + 2);
+        return pools;
+    }
+
+    // 第一次用到某个size class时才建立它的池
+    static ChunkPool &arrayPool(size_t size)
+    {
+        size_t index = (size + ARRAY_GRANULE - 1) / ARRAY_GRANULE;
+        std::unique_ptr<ChunkPool> &p = arrayPools()[index];
+        // chunk字节数上限与标量池相同
+        if (!p)
+            p.reset(new ChunkPool(index * ARRAY_GRANULE, arrayAlign(), 0,
+                                  ChunkPolicy::maxObjs * sizeof(T) / (index * ARRAY_GRANULE) + 1));
+        return *p;
+    }
+};
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <complex>
+#include <chrono>
+#include <vector>
+#include "../13_poolAllocatedMixin/poolAllocated.hpp"
+using namespace std;
+
+class Foo : public PoolAllocated<Foo>
+{
+public:
+    long L;
+    string str;
+    Foo() : L(0) {}
+};
+
+// 元素个数不超过16的数组走池
+class Goo : public PoolAllocated<Goo, FixedChunk<256, 16>>
+{
+public:
+    complex<double> c;
+};
+
+class Screen : public PoolAllocated<Screen>
+{
+public:
+    int id = 0;
+};
+
+class Airplane : public PoolAllocated<Airplane, GeometricChunk<512, 65536>>
+{
+private:
+    struct AirplaneRep
+    {
+        unsigned long miles;
+        char type;
+    };
+    AirplaneRep rep{};
+
+public:
+    void set(unsigned long m, char t)
+    {
+        rep.miles = m;
+        rep.type = t;
+    }
+};
+
+// 与上面布局相同、不重载operator new[]的版本，走全局堆
+struct PlainFoo
+{
+    long L = 0;
+    string str;
+};
+struct PlainGoo
+{
+    complex<double> c;
+};
+struct PlainScreen
+{
+    int id = 0;
+};
+
+// 连续new三个n元素数组，打印地址和相邻间隔：间隔 = 数组字节数 + cookie + 分配器自身的开销
+template <typename T>
+void arrayLayout(const string &name, size_t n)
+{
+    T *a = new T[n];
+    T *b = new T[n];
+    T *c = new T[n];
+    cout << left << setw(12) << name << right << " n = " << n << ", n*sizeof = " << setw(4) << n * sizeof(T)
+         << ", a = " << a << ", b-a = " << setw(4) << (char *)b - (char *)a
+         << ", c-b = " << setw(4) << (char *)c - (char *)b << endl;
+    delete[] c;
+    delete[] b;
+    delete[] a;
+}
+
+template <typename T>
+double bench_ns(size_t N, size_t n)
+{
+    vector<T *> v(N);
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < 10; ++r)
+    {
+        for (size_t i = 0; i < N; ++i)
+            v[i] = new T[n];
+        for (size_t i = 0; i < N; ++i)
+            delete[] v[i];
+    }
+    chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+    return d.count() / (20 * N);
+}
+
+int main()
+{
+    // 1. 地址间隔：池中的数组紧挨着，只多了编译器的cookie(记录元素个数)，没有malloc的块头
+    {
+        arrayLayout<Foo>("Foo", 4);
+        arrayLayout<PlainFoo>("PlainFoo", 4);
+        arrayLayout<Goo>("Goo", 4);
+        arrayLayout<PlainGoo>("PlainGoo", 4);
+        arrayLayout<Screen>("Screen", 3);
+        arrayLayout<PlainScreen>("PlainScreen", 3);
+        arrayLayout<Airplane>("Airplane", 8);
+        arrayLayout<Goo>("Goo(>16)", 32); // 超过maxArray，转交::operator new[]
+    }
+
+    // 2. 每个size class一个池
+    {
+        Airplane *a1 = new Airplane[1];
+        Airplane *a2 = new Airplane[2];
+        Airplane *a8 = new Airplane[8];
+        a8[7].set(7000, 'C');
+        ChunkPool::Stats s = Airplane::arrayPoolStats();
+        cout << "\nAirplane array pools: live = " << s.liveObjects << ", chunks = " << s.chunks
+             << ", reserved = " << s.reservedBytes << " B" << endl;
+        delete[] a8;
+        delete[] a2;
+        delete[] a1;
+        cout << "trim released " << Airplane::trimPool() << " B" << endl;
+    }
+
+    // 3. new T[4] + delete[]的开销(ns/op)
+    {
+        const size_t N = 100000;
+        cout << "\nnew[4]+delete[] (ns/op): Foo = " << bench_ns<Foo>(N, 4)
+             << ", PlainFoo = " << bench_ns<PlainFoo>(N, 4)
+             << ", Goo = " << bench_ns<Goo>(N, 4)
+             << ", PlainGoo = " << bench_ns<PlainGoo>(N, 4) << endl;
+    }
+    return 0;
+}
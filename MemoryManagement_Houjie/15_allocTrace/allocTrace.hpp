@@ -0,0 +1,308 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+// 分配事件追踪：代替2_overloadOperatorNewDelete中每次调用都cout的做法
+// 1. 每个线程一个单生产者/单消费者的环形缓冲区，记录事件只需几次普通写和一次release store，不加锁；
+// 2. 后台drain线程定期把所有环中的事件批量fwrite到二进制文件；
+// 3. 环满时丢弃事件并计数，绝不阻塞业务线程；
+// 4. 可以按地址采样，只记录1/2^sampleShift的块：同一个地址的new和delete要么都记录、要么都不记录，
+//    配对关系不受影响，没被采样的事件只多一次乘法和比较。长期在线上开着追踪时用采样模式。
+class AllocTracer
+{
+public:
+    enum Op : uint32_t
+    {
+        NEW,
+        NEW_ARRAY,
+        DELETE,
+        DELETE_ARRAY
+    };
+
+    // 32字节定长记录，直接按内存布局写入文件
+    struct Event
+    {
+        uint64_t timestamp; // TSC计数(x86)或steady_clock纳秒
+        uint64_t ptr;
+        uint64_t size; // 释放事件没有大小时为0
+        uint32_t tid;  // 追踪器分配的线程编号，从1开始
+        uint32_t op;
+    };
+
+    struct FileHeader
+    {
+        char magic[4]; // "ATRC"
+        uint32_t version;
+        uint32_t eventSize;
+        uint32_t sampleShift; // 记录了1/2^sampleShift的块，0表示全部记录
+        double ticksPerNs; // timestamp换算成纳秒的比例
+    };
+
+    static const size_t RING_CAPACITY = 1 << 15; // 每线程32768个事件(1MB)
+    static const int MAX_THREADS = 256;
+
+private:
+    struct Ring
+    {
+        alignas(64) std::atomic<uint64_t> head; // 生产者(业务线程)写
+        alignas(64) std::atomic<uint64_t> tail; // 消费者(drain线程)写
+        std::atomic<bool> retired;              // 所属线程已退出，drain完即可释放
+        std::atomic<uint64_t> dropped;
+        uint32_t tid;
+        Event events[RING_CAPACITY];
+    };
+
+    // thread_local，零初始化；保持平凡类型，热路径上访问它不需要经过TLS初始化检查
+    struct ThreadState
+    {
+        Ring *ring;
+        bool busy;   // 正在追踪器内部(或drain线程、线程已退出)，此时的分配不记录，防止递归
+        bool noRing; // 注册失败(线程表已满或malloc失败)，之后的事件直接丢弃，不再重试
+    };
+
+    // 线程退出时把环标记为retired，只在注册环时构造一次
+    struct RingOwner
+    {
+        ~RingOwner()
+        {
+            tls.busy = true;
+            if (tls.ring)
+                tls.ring->retired.store(true, std::memory_order_release);
+        }
+    };
+
+public:
+    // 开始追踪，事件写入path，只记录地址哈希后落在1/2^sampleShift中的块；
+    // 已在追踪中或文件打不开时返回false
+    static bool start(const char *path, unsigned sampleShift = 0)
+    {
+        ThreadState &ts = tls;
+        ts.busy = true;
+        if (enabled.load() || !(file = fopen(path, "wb")))
+        {
+            ts.busy = false;
+            return false;
+        }
+        sampleMask.store(sampleShift ? (uint64_t(1) << (sampleShift < 32 ? sampleShift : 32)) - 1 : 0, std::memory_order_relaxed);
+        FileHeader h{{'A', 'T', 'R', 'C'}, 2, sizeof(Event), sampleShift < 32 ? sampleShift : 32, calibrate()};
+        fwrite(&h, sizeof(h), 1, file);
+        written = 0;
+        running.store(true);
+        drainer = std::thread(drainLoop);
+        enabled.store(true, std::memory_order_release);
+        ts.busy = false;
+        return true;
+    }
+
+    // 停止追踪，等drain线程把剩余事件写完并关闭文件
+    static void stop()
+    {
+        ThreadState &ts = tls;
+        ts.busy = true;
+        if (enabled.exchange(false))
+        {
+            running.store(false);
+            drainer.join();
+            drainAll(true);
+            fclose(file);
+            file = nullptr;
+        }
+        ts.busy = false;
+    }
+
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static uint64_t writtenEvents() { return written; }
+    static uint64_t droppedEvents() { return droppedTotal.load(); }
+
+    // 为当前线程注册环。否则注册(分配、清零1MB)发生在这个线程第一次记录事件时；
+    // 采样时哪一次分配会被记录是不确定的，要在意延迟的线程应该在开始工作前先调用它
+    static bool registerThread()
+    {
+        if (!enabled.load(std::memory_order_acquire))
+            return false;
+        ThreadState &ts = tls;
+        return ts.ring || (!ts.busy && attach(ts));
+    }
+
+    // 热路径：由全局operator new/delete调用
+    static void record(Op op, void *ptr, size_t size)
+    {
+        if (!enabled.load(std::memory_order_relaxed))
+            return;
+        if (!sampled(ptr))
+            return;
+        ThreadState &ts = tls;
+        if (ts.busy)
+            return;
+        Ring *r = ts.ring;
+        if (!r && !(r = attach(ts)))
+        {
+            droppedTotal.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        uint64_t h = r->head.load(std::memory_order_relaxed);
+        if (h - r->tail.load(std::memory_order_acquire) >= RING_CAPACITY)
+        {
+            r->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Event &e = r->events[h & (RING_CAPACITY - 1)];
+        e.timestamp = timestamp();
+        e.ptr = reinterpret_cast<uint64_t>(ptr);
+        e.size = size;
+        e.tid = r->tid;
+        e.op = op;
+        r->head.store(h + 1, std::memory_order_release);
+    }
+
+    // 乘以黄金分割常数打散地址的高低位，取高位判断；malloc返回的地址低4位总是0，不能直接用
+    static bool sampled(void *ptr)
+    {
+        uint64_t mask = sampleMask.load(std::memory_order_relaxed);
+        return !mask || ((reinterpret_cast<uint64_t>(ptr) * 0x9E3779B97F4A7C15ull) >> 32 & mask) == 0;
+    }
+
+private:
+    static uint64_t timestamp()
+    {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    // 用steady_clock测量10ms内timestamp()走了多少
+    static double calibrate()
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = timestamp();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        uint64_t c1 = timestamp();
+        std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - t0;
+        return double(c1 - c0) / d.count();
+    }
+
+    static Ring *attach(ThreadState &ts)
+    {
+        if (ts.noRing)
+            return nullptr;
+        ts.busy = true;
+        Ring *r = ts.ring = registerRing();
+        ts.noRing = !r;
+        ts.busy = false;
+        return r;
+    }
+
+    // 占住的空位，环还没有准备好；drain线程跳过它
+    static Ring *reserved() { return reinterpret_cast<Ring *>(uintptr_t(1)); }
+
+    // 先占一个空位，再分配环：线程表满时不必分配、清零1MB再释放掉
+    // 环用malloc分配，不经过operator new
+    static Ring *registerRing()
+    {
+        int slot = -1;
+        for (int i = 0; i < MAX_THREADS && slot < 0; ++i)
+        {
+            Ring *expected = nullptr;
+            if (slots[i].compare_exchange_strong(expected, reserved()))
+                slot = i;
+        }
+        if (slot < 0)
+            return nullptr;
+        void *mem = malloc(sizeof(Ring));
+        if (!mem)
+        {
+            slots[slot].store(nullptr);
+            return nullptr;
+        }
+        Ring *r = static_cast<Ring *>(mem);
+        new (&r->head) std::atomic<uint64_t>(0);
+        new (&r->tail) std::atomic<uint64_t>(0);
+        new (&r->retired) std::atomic<bool>(false);
+        new (&r->dropped) std::atomic<uint64_t>(0);
+        r->tid = nextTid.fetch_add(1) + 1;
+        memset(r->events, 0, sizeof(r->events)); // 预先触发缺页，不让它落在record()里
+        static thread_local RingOwner owner;
+        (void)owner;
+        slots[slot].store(r, std::memory_order_release);
+        return r;
+    }
+
+    static void drainLoop()
+    {
+        tls.busy = true; // drain线程自身的分配不记录
+        // 只要有事件就马上再drain，事件稀疏(例如采样)时drain线程几乎不停地醒来、每次只写几个事件，
+        // 与业务线程抢CPU。所以这一轮写得不多就睡1ms，让事件在环中攒一批再写
+        while (running.load())
+        {
+            if (drainAll(false) < RING_CAPACITY / 4)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // 把所有环中已提交的事件写入文件，返回写入的事件数；final为true时释放所有环
+    static size_t drainAll(bool final)
+    {
+        size_t n = 0;
+        for (int i = 0; i < MAX_THREADS; ++i)
+        {
+            Ring *r = slots[i].load(std::memory_order_acquire);
+            if (!r || r == reserved())
+                continue;
+            bool retired = r->retired.load(std::memory_order_acquire);
+            uint64_t t = r->tail.load(std::memory_order_relaxed);
+            uint64_t h = r->head.load(std::memory_order_acquire);
+            // 环形缓冲区可能在末尾折回，分两段写
+            while (t != h)
+            {
+                size_t begin = t & (RING_CAPACITY - 1);
+                size_t count = size_t(h - t);
+                if (begin + count > RING_CAPACITY)
+                    count = RING_CAPACITY - begin;
+                fwrite(&r->events[begin], sizeof(Event), count, file);
+                t += count;
+                n += count;
+                r->tail.store(t, std::memory_order_release);
+            }
+            if (retired || final)
+            {
+                droppedTotal.fetch_add(r->dropped.load());
+                if (retired)
+                {
+                    slots[i].store(nullptr);
+                    free(r);
+                }
+                else
+                    r->dropped.store(0);
+            }
+        }
+        written += n;
+        return n;
+    }
+
+private:
+    static inline std::atomic<bool> enabled{false};
+    static inline std::atomic<bool> running{false};
+    static inline std::atomic<uint64_t> sampleMask{0}; // 只在start()中、enabled之前修改
+    static inline std::atomic<uint32_t> nextTid{0};
+    static inline std::atomic<uint64_t> droppedTotal{0};
+    static inline std::atomic<Ring *> slots[MAX_THREADS] = {};
+    static inline std::thread drainer;
+    static inline FILE *file = nullptr;
+    static inline uint64_t written = 0; // 只由drain线程(或stop)修改
+    static inline thread_local ThreadState tls;
+};
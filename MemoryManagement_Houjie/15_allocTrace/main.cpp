@@ -0,0 +1,296 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include "allocTrace.hpp"
+using namespace std;
+
+// 全局operator new/delete的三种模式：不记录、2_overloadOperatorNewDelete那样逐条打印、写入追踪环
+enum Mode
+{
+    OFF,
+    TEXT_LOG,
+    TRACE
+};
+Mode mode = OFF;
+FILE *textLog = nullptr;
+
+void *myAlloc(size_t size, AllocTracer::Op op)
+{
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw bad_alloc();
+    if (mode == TRACE)
+        AllocTracer::record(op, p, size);
+    else if (mode == TEXT_LOG)
+    {
+        fprintf(textLog, "my global new(), size = %zu, return %p\n", size, p);
+        fflush(textLog); // 相当于cout << endl
+    }
+    return p;
+}
+
+void myFree(void *ptr, size_t size, AllocTracer::Op op)
+{
+    if (!ptr)
+        return;
+    if (mode == TRACE)
+        AllocTracer::record(op, ptr, size);
+    else if (mode == TEXT_LOG)
+    {
+        fprintf(textLog, "my global delete(), ptr = %p\n", ptr);
+        fflush(textLog);
+    }
+    free(ptr);
+}
+
+// 替换用的全局operator new/delete不能是inline，放在.cpp中定义
+void *operator new(size_t size) { return myAlloc(size, AllocTracer::NEW); }
+void *operator new[](size_t size) { return myAlloc(size, AllocTracer::NEW_ARRAY); }
+void operator delete(void *ptr) noexcept { myFree(ptr, 0, AllocTracer::DELETE); }
+void operator delete[](void *ptr) noexcept { myFree(ptr, 0, AllocTracer::DELETE_ARRAY); }
+void operator delete(void *ptr, size_t size) noexcept { myFree(ptr, size, AllocTracer::DELETE); }
+void operator delete[](void *ptr, size_t size) noexcept { myFree(ptr, size, AllocTracer::DELETE_ARRAY); }
+// nothrow版本也要一起替换，否则它分配的内存会被上面的delete用free释放(标准库的stable_sort等会用到)
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+    try
+    {
+        return myAlloc(size, AllocTracer::NEW);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+    try
+    {
+        return myAlloc(size, AllocTracer::NEW_ARRAY);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+// 每个线程做一些容器操作，产生大量小块分配
+void work(int id, int rounds)
+{
+    for (int r = 0; r < rounds; ++r)
+    {
+        vector<string> v;
+        map<int, string> m;
+        for (int i = 0; i < 200; ++i)
+        {
+            v.push_back("a string that is longer than SSO #" + to_string(i));
+            m[i * id] = v.back();
+        }
+        int *arr = new int[r % 64 + 1];
+        arr[0] = r;
+        delete[] arr;
+    }
+}
+
+// 计时运行一次(ms)
+// 线程先注册好追踪环(分配、清零1MB)，全部就绪后才开始计时，创建线程和注册环都不计入
+double runWorkload(int threads, int rounds)
+{
+    atomic<int> ready{0};
+    atomic<bool> go{false};
+    vector<thread> ts;
+    for (int i = 0; i < threads; ++i)
+        ts.emplace_back([&, i]
+                        {
+                            if (mode == TRACE)
+                                AllocTracer::registerThread();
+                            ready.fetch_add(1);
+                            while (!go.load())
+                                this_thread::yield();
+                            work(i + 1, rounds); });
+    while (ready.load() < threads)
+        this_thread::yield();
+    auto start = chrono::steady_clock::now();
+    go.store(true);
+    for (auto &t : ts)
+        t.join();
+    chrono::duration<double, milli> d = chrono::steady_clock::now() - start;
+    return d.count();
+}
+
+// 单线程反复new/delete 4096个48字节的块，返回每次new或delete的ns
+// 与不追踪时相减，就是每个事件的追踪开销；业务线程之间没有切换，比多线程的测试稳定
+double perOpNs()
+{
+    const int BATCH = 4096, ROUNDS = 200;
+    vector<char *> ps(BATCH);
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; ++r)
+    {
+        for (char *&p : ps)
+            p = new char[48];
+        for (char *p : ps)
+            delete[] p;
+    }
+    chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+    return d.count() / (2.0 * BATCH * ROUNDS);
+}
+
+// 读回追踪文件并汇总
+void summarize(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    AllocTracer::FileHeader h;
+    if (!f || fread(&h, sizeof(h), 1, f) != 1 || string(h.magic, 4) != "ATRC" || h.eventSize != sizeof(AllocTracer::Event))
+    {
+        cout << "bad trace file " << path << endl;
+        if (f)
+            fclose(f);
+        return;
+    }
+
+    const char *opName[] = {"new", "new[]", "delete", "delete[]"};
+    size_t opCount[4] = {};
+    map<uint32_t, size_t> perThread;
+    map<int, size_t> sizeHist; // 按2的幂分桶
+    unordered_map<uint64_t, uint64_t> live;
+    size_t total = 0, unmatched = 0;
+    uint64_t first = UINT64_MAX, last = 0, bytes = 0;
+
+    // 文件中的事件按drain的顺序排列(一个线程一段)，先按时间戳排序再配对new/delete
+    vector<AllocTracer::Event> events;
+    AllocTracer::Event ev;
+    while (fread(&ev, sizeof(ev), 1, f) == 1)
+        events.push_back(ev);
+    stable_sort(events.begin(), events.end(),
+                [](const AllocTracer::Event &a, const AllocTracer::Event &b)
+                { return a.timestamp < b.timestamp; });
+
+    for (const AllocTracer::Event &e : events)
+    {
+        ++total;
+        ++opCount[e.op];
+        ++perThread[e.tid];
+        first = min(first, e.timestamp);
+        last = max(last, e.timestamp);
+        if (e.op == AllocTracer::NEW || e.op == AllocTracer::NEW_ARRAY)
+        {
+            bytes += e.size;
+            int b = 0;
+            while ((uint64_t(1) << b) < e.size)
+                ++b;
+            ++sizeHist[b];
+            live[e.ptr] = e.size;
+        }
+        else if (!live.erase(e.ptr))
+            ++unmatched; // 对应的new发生在追踪开始之前，或被丢弃
+    }
+    fclose(f);
+
+    cout << "events = " << total << ", span = " << fixed << setprecision(1)
+         << (last - first) / h.ticksPerNs / 1e6 << " ms, allocated = " << bytes / 1024 << " KB";
+    if (h.sampleShift)
+        cout << " (sampled 1/" << (1ull << h.sampleShift) << ", estimated " << (bytes << h.sampleShift) / 1024 << " KB)";
+    cout << endl;
+    for (int i = 0; i < 4; ++i)
+        cout << "  " << left << setw(9) << opName[i] << right << setw(10) << opCount[i] << endl;
+    cout << "per thread:";
+    for (auto &p : perThread)
+        cout << " T" << p.first << "=" << p.second;
+    cout << "\nsize histogram:";
+    for (auto &p : sizeHist)
+        cout << " <=" << (1ull << p.first) << ":" << p.second;
+    cout << "\nlive at stop = " << live.size() << ", unmatched frees = " << unmatched << endl;
+}
+
+int main()
+{
+    const int THREADS = 4, ROUNDS = 100;
+    const char *path = "alloc_trace.bin";
+#ifdef _WIN32
+    textLog = fopen("NUL", "w");
+#else
+    textLog = fopen("/dev/null", "w");
+#endif
+
+    // 1. 各模式的耗时
+    // 每次运行后堆的状态都会变化，越往后越慢；所以各模式轮流运行REPEAT遍，每种取最快的一次，而不是一种跑完再跑下一种
+    const int REPEAT = 7;
+    const unsigned SAMPLE_SHIFT = 6; // 采样1/64
+    const char *sampledPath = "alloc_trace_sampled.bin";
+    double tOff = 1e30, tText = 1e30, tTrace = 1e30, tSampled = 1e30;
+    uint64_t fullWritten = 0, fullDropped = 0, sampledWritten = 0, sampledDropped = 0;
+    runWorkload(THREADS, ROUNDS / 10); // 预热
+    for (int k = 0; k < REPEAT; ++k)
+    {
+        mode = OFF;
+        tOff = min(tOff, runWorkload(THREADS, ROUNDS));
+
+        mode = TEXT_LOG;
+        tText = min(tText, runWorkload(THREADS, ROUNDS));
+
+        // 全部记录；文件只保留最后一遍的
+        mode = TRACE;
+        uint64_t dropped = AllocTracer::droppedEvents();
+        AllocTracer::start(path);
+        tTrace = min(tTrace, runWorkload(THREADS, ROUNDS));
+        AllocTracer::stop();
+        fullWritten = AllocTracer::writtenEvents();
+        fullDropped = AllocTracer::droppedEvents() - dropped;
+
+        // 按地址采样
+        dropped = AllocTracer::droppedEvents();
+        AllocTracer::start(sampledPath, SAMPLE_SHIFT);
+        tSampled = min(tSampled, runWorkload(THREADS, ROUNDS));
+        AllocTracer::stop();
+        sampledWritten = AllocTracer::writtenEvents();
+        sampledDropped = AllocTracer::droppedEvents() - dropped;
+        mode = OFF;
+    }
+
+    cout << fixed << setprecision(1) << "off = " << tOff << " ms, text log = " << tText
+         << " ms (+" << (tText / tOff - 1) * 100 << "%), trace = " << tTrace
+         << " ms (+" << (tTrace / tOff - 1) * 100 << "%), trace 1/" << (1 << SAMPLE_SHIFT) << " = " << tSampled
+         << " ms (+" << (tSampled / tOff - 1) * 100 << "%)" << endl;
+    cout << "full trace: written = " << fullWritten << ", dropped = " << fullDropped << endl;
+    cout << "sampled trace: written = " << sampledWritten << ", dropped = " << sampledDropped << endl;
+    fclose(textLog);
+
+    // 2. 读回追踪文件
+    summarize(path);
+    summarize(sampledPath);
+    remove(path);
+    remove(sampledPath);
+
+    // 3. 每个事件的开销，同样轮流运行、各取最快的一次
+    //    第1节之后进程中已经有过多个线程，glibc的malloc已经进入多线程模式，三种情况的前提相同
+    double opOff = 1e30, opTrace = 1e30, opSampled = 1e30;
+    for (int k = 0; k < REPEAT; ++k)
+    {
+        mode = OFF;
+        opOff = min(opOff, perOpNs());
+        mode = TRACE;
+        AllocTracer::start(path);
+        AllocTracer::registerThread();
+        opTrace = min(opTrace, perOpNs());
+        AllocTracer::stop();
+        AllocTracer::start(sampledPath, SAMPLE_SHIFT);
+        AllocTracer::registerThread();
+        opSampled = min(opSampled, perOpNs());
+        AllocTracer::stop();
+        mode = OFF;
+    }
+    remove(path);
+    remove(sampledPath);
+    cout << setprecision(2) << "per new/delete: off = " << opOff << " ns, trace +" << opTrace - opOff
+         << " ns, trace 1/" << (1 << SAMPLE_SHIFT) << " +" << opSampled - opOff << " ns" << endl;
+    return 0;
+}
@@ -0,0 +1,316 @@
+// 用LD_PRELOAD注入的堆分析库：
+//   LD_PRELOAD=./libheapprof.so ./app
+// 替换全局operator new/delete(沿用2_overloadOperatorNewDelete的myAlloc/myFree)，统计
+// 大小分布、当前/峰值字节数，并按分配字节数抽样记录调用栈。
+// 报告在进程退出时输出；运行中向进程发送信号(默认SIGUSR2)也会输出一份。
+// 环境变量：
+//   HEAPPROF_SAMPLE  抽样间隔(字节)，默认524288，0表示不抽样
+//   HEAPPROF_SIGNAL  触发输出的信号编号，默认SIGUSR2
+//   HEAPPROF_OUT     报告追加写入的文件，默认stderr
+#include <atomic>
+#include <cstdarg>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <mutex>
+#include <new>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace
+{
+const int BUCKETS = 22; // <=8B, <=16B, ... <=8MB, 更大
+const int MAX_DEPTH = 24;
+const int MAX_STACKS = 1024;
+const int TOP_N = 10;
+
+struct StackEntry
+{
+    uint64_t hash;
+    int depth;
+    void *frames[MAX_DEPTH];
+    uint64_t samples;
+    uint64_t bytes; // 按抽样权重估算的分配字节数
+};
+
+// 全部是常量初始化，其他库的静态构造函数里调用operator new也是安全的
+std::atomic<uint64_t> allocCount{0}, freeCount{0};
+std::atomic<uint64_t> liveBytes{0}, peakBytes{0}; // 按malloc_usable_size计，即真正占用的堆
+std::atomic<uint64_t> histCount[BUCKETS], histBytes[BUCKETS];
+
+std::mutex stackMtx;
+StackEntry stacks[MAX_STACKS];
+uint64_t totalSamples = 0, droppedSamples = 0;
+
+size_t sampleInterval = 512 * 1024;
+const char *outPath = nullptr;
+int pipeFds[2] = {-1, -1};
+void *selfBase = nullptr;      // 本库的加载地址，用来从调用栈中去掉本库的帧
+std::atomic<bool> ready{false}; // 构造函数执行完之后才抽样
+
+// 平凡类型，零初始化
+thread_local bool busy;             // 正在抽样或输出报告，期间的分配不抽样
+thread_local int64_t untilSample;   // 本线程再分配多少字节后抽样一次
+
+int bucketOf(size_t size)
+{
+    int b = 0;
+    while (b < BUCKETS - 1 && (size_t(8) << b) < size)
+        ++b;
+    return b;
+}
+
+// 慢路径：记录当前调用栈，每个样本代表max(size, sampleInterval)字节
+__attribute__((noinline)) void sample(size_t size)
+{
+    busy = true;
+    void *raw[MAX_DEPTH + 8];
+    int n = backtrace(raw, MAX_DEPTH + 8);
+    int skip = 0;
+    Dl_info info;
+    while (skip < n && dladdr(raw[skip], &info) && info.dli_fbase == selfBase)
+        ++skip;
+    int depth = n - skip < MAX_DEPTH ? n - skip : MAX_DEPTH;
+    void **frames = raw + skip;
+
+    uint64_t h = 14695981039346656037ull; // FNV-1a
+    for (int i = 0; i < depth; ++i)
+        h = (h ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ull;
+    uint64_t weight = size > sampleInterval ? size : sampleInterval;
+
+    {
+        std::lock_guard<std::mutex> lk(stackMtx);
+        ++totalSamples;
+        // 开放寻址
+        for (int i = 0; i < MAX_STACKS; ++i)
+        {
+            StackEntry &e = stacks[(h + i) % MAX_STACKS];
+            if (e.samples == 0)
+            {
+                e.hash = h;
+                e.depth = depth;
+                memcpy(e.frames, frames, depth * sizeof(void *));
+            }
+            else if (e.hash != h)
+                continue;
+            ++e.samples;
+            e.bytes += weight;
+            busy = false;
+            return;
+        }
+        ++droppedSamples;
+    }
+    busy = false;
+}
+
+void account(void *p, size_t size)
+{
+    uint64_t real = malloc_usable_size(p);
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    uint64_t live = liveBytes.fetch_add(real, std::memory_order_relaxed) + real;
+    uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        ;
+    int b = bucketOf(size);
+    histCount[b].fetch_add(1, std::memory_order_relaxed);
+    histBytes[b].fetch_add(size, std::memory_order_relaxed);
+
+    if (sampleInterval && (untilSample -= int64_t(size)) <= 0)
+    {
+        untilSample = int64_t(sampleInterval);
+        if (!busy && ready.load(std::memory_order_acquire))
+            sample(size);
+    }
+}
+
+void *myAlloc(size_t size)
+{
+    void *p = malloc(size ? size : 1);
+    if (p)
+        account(p, size);
+    return p;
+}
+
+void myFree(void *ptr)
+{
+    if (!ptr)
+        return;
+    freeCount.fetch_add(1, std::memory_order_relaxed);
+    liveBytes.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+    free(ptr);
+}
+
+void print(int fd, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void print(int fd, const char *fmt, ...)
+{
+    char buf[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (len > 0)
+    {
+        ssize_t r = write(fd, buf, len < int(sizeof(buf)) ? len : sizeof(buf) - 1);
+        (void)r;
+    }
+}
+
+void dump(const char *reason)
+{
+    busy = true;
+    int fd = outPath ? open(outPath, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644) : STDERR_FILENO;
+    if (fd < 0)
+        fd = STDERR_FILENO;
+
+    print(fd, "==== heapprof: pid %d, %s ====\n", int(getpid()), reason);
+    print(fd, "allocs %llu, frees %llu, live %llu B, peak %llu B\n",
+          (unsigned long long)allocCount.load(), (unsigned long long)freeCount.load(),
+          (unsigned long long)liveBytes.load(), (unsigned long long)peakBytes.load());
+    print(fd, "%12s %14s %16s\n", "size", "count", "bytes");
+    for (int b = 0; b < BUCKETS; ++b)
+    {
+        uint64_t c = histCount[b].load();
+        if (!c)
+            continue;
+        char label[32];
+        if (b == BUCKETS - 1)
+            snprintf(label, sizeof(label), ">%zu", size_t(8) << (b - 1));
+        else
+            snprintf(label, sizeof(label), "<=%zu", size_t(8) << b);
+        print(fd, "%12s %14llu %16llu\n", label, (unsigned long long)c, (unsigned long long)histBytes[b].load());
+    }
+
+    // 在锁内选出前TOP_N个，拷贝出来再输出，不在持锁时做I/O
+    StackEntry top[TOP_N];
+    int nTop = 0;
+    uint64_t samples, dropped;
+    {
+        std::lock_guard<std::mutex> lk(stackMtx);
+        samples = totalSamples;
+        dropped = droppedSamples;
+        for (int i = 0; i < MAX_STACKS; ++i)
+        {
+            const StackEntry &e = stacks[i];
+            if (!e.samples || (nTop == TOP_N && e.bytes <= top[TOP_N - 1].bytes))
+                continue;
+            // 插入排序，top按bytes从大到小
+            int pos = nTop < TOP_N ? nTop++ : TOP_N - 1;
+            while (pos > 0 && top[pos - 1].bytes < e.bytes)
+            {
+                top[pos] = top[pos - 1];
+                --pos;
+            }
+            top[pos] = e;
+        }
+    }
+    print(fd, "top %d allocation stacks (sampled every %zu B, %llu samples, %llu dropped):\n",
+          nTop, sampleInterval, (unsigned long long)samples, (unsigned long long)dropped);
+    for (int i = 0; i < nTop; ++i)
+    {
+        print(fd, "#%d ~%llu KB in %llu samples\n", i + 1,
+              (unsigned long long)(top[i].bytes / 1024), (unsigned long long)top[i].samples);
+        backtrace_symbols_fd(top[i].frames, top[i].depth, fd); // 直接写fd，不分配内存
+    }
+    print(fd, "==== end ====\n");
+
+    if (fd != STDERR_FILENO)
+        close(fd);
+    busy = false;
+}
+
+// 信号处理函数里只能调用异步信号安全的函数：往管道里写一个字节，由dumper线程输出报告
+void onSignal(int)
+{
+    int saved = errno;
+    char c = 'd';
+    ssize_t r = write(pipeFds[1], &c, 1);
+    (void)r;
+    errno = saved;
+}
+
+void *dumperLoop(void *)
+{
+    char c;
+    for (;;)
+    {
+        ssize_t r = read(pipeFds[0], &c, 1);
+        if (r == 1)
+            dump("signal");
+        else if (r == 0 || errno != EINTR)
+            return nullptr;
+    }
+}
+
+__attribute__((constructor)) void heapprofInit()
+{
+    busy = true;
+    if (const char *s = getenv("HEAPPROF_SAMPLE"))
+        sampleInterval = strtoull(s, nullptr, 10);
+    outPath = getenv("HEAPPROF_OUT");
+    int sig = SIGUSR2;
+    if (const char *s = getenv("HEAPPROF_SIGNAL"))
+        sig = atoi(s);
+
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void *>(&heapprofInit), &info))
+        selfBase = info.dli_fbase;
+    // 第一次调用backtrace会加载libgcc_s并分配内存，提前在这里做掉
+    void *warm[4];
+    backtrace(warm, 4);
+
+    if (pipe2(pipeFds, O_CLOEXEC) == 0)
+    {
+        pthread_t tid;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&tid, &attr, dumperLoop, nullptr) == 0)
+        {
+            struct sigaction sa;
+            memset(&sa, 0, sizeof(sa));
+            sa.sa_handler = onSignal;
+            sa.sa_flags = SA_RESTART;
+            sigemptyset(&sa.sa_mask);
+            sigaction(sig, &sa, nullptr);
+        }
+        pthread_attr_destroy(&attr);
+    }
+    busy = false;
+    ready.store(true, std::memory_order_release);
+}
+
+__attribute__((destructor)) void heapprofFini()
+{
+    dump("exit");
+}
+} // namespace
+
+// 与标准库的operator new一样：分配失败时反复调用new_handler(见7_newhandlerAndNothrow)
+void *operator new(size_t size)
+{
+    void *p;
+    while (!(p = myAlloc(size)))
+    {
+        std::new_handler h = std::get_new_handler();
+        if (!h)
+            throw std::bad_alloc();
+        h();
+    }
+    return p;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return myAlloc(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return myAlloc(size); }
+void operator delete(void *ptr) noexcept { myFree(ptr); }
+void operator delete[](void *ptr) noexcept { myFree(ptr); }
+void operator delete(void *ptr, size_t) noexcept { myFree(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { myFree(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { myFree(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { myFree(ptr); }
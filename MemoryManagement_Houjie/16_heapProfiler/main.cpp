@@ -0,0 +1,76 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#ifdef __linux__
+#include <csignal>
+#endif
+using namespace std;
+
+// 几个分配模式不同的调用点，用来在heapprof的报告中区分
+
+// 一直持有：2万个节点的map
+map<int, string> *buildIndex()
+{
+    map<int, string> *index = new map<int, string>;
+    for (int i = 0; i < 20000; ++i)
+        (*index)[i] = "value string for key " + to_string(i);
+    return index;
+}
+
+// 分配后马上释放：只推高累计分配量，不影响live
+size_t churnStrings(int rounds)
+{
+    size_t total = 0;
+    for (int r = 0; r < rounds; ++r)
+    {
+        vector<string> v;
+        for (int i = 0; i < 100; ++i)
+            v.push_back(string(100 + i, 'x'));
+        total += v.size();
+    }
+    return total;
+}
+
+// 忘记释放的大块
+void leakBuffers(int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        char *buf = new char[64 * 1024];
+        memset(buf, i, 64 * 1024);
+    }
+}
+
+bool preloaded()
+{
+    const char *p = getenv("LD_PRELOAD");
+    return p && strstr(p, "heapprof");
+}
+
+int main()
+{
+    if (!preloaded())
+        cout << "未加载heapprof，用法: LD_PRELOAD=./build/libheapprof.so ./build/16_heapProfiler" << endl;
+
+    map<int, string> *index = buildIndex();
+    cout << "churn: " << churnStrings(2000) << endl;
+    leakBuffers(50);
+
+#ifdef __linux__
+    // 运行中触发一次报告，效果与 kill -USR2 <pid> 相同
+    if (preloaded())
+    {
+        raise(SIGUSR2);
+        this_thread::sleep_for(chrono::milliseconds(100)); // 等dumper线程输出
+    }
+#endif
+
+    delete index;
+    cout << "done" << endl;
+    return 0;
+}
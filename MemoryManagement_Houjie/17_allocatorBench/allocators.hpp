@@ -0,0 +1,306 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#ifdef __GNUC__
+#include <ext/pool_allocator.h>
+#endif
+#include "../9_threadCacheAllocator/threadCacheAllocator.hpp"
+#include "../10_stdAllocImpl/stdAlloc.hpp"
+#include "../11_trimmablePool/chunkPool.hpp"
+
+// 把本目录下各章的分配器包装成统一的接口，供基准测试和开销分析使用：
+//   static const char *name();
+//   static constexpr bool anySize;    // 能分配任意大小；否则只能分配BLOCK字节
+//   static constexpr bool threadSafe; // 可以在一个线程分配、另一个线程释放
+//   static void *allocate(size_t n);
+//   static void deallocate(void *p, size_t n);
+
+// 定长分配器(Screen、Airplane等)统一使用的块大小，即64位下sizeof(Screen)
+const size_t BLOCK = 16;
+
+// ==================== 3_perClassAllocator ====================
+// 去掉了cout，其余与原文相同
+class Screen
+{
+public:
+    Screen(int x) : id(x) {}
+    int get() { return id; }
+
+    void *operator new(size_t size)
+    {
+        Screen *p;
+        if (!freeStore)
+        {
+            size_t chunk = screenChunk * size;
+            freeStore = reinterpret_cast<Screen *>(new char[chunk]);
+            for (p = freeStore; p != &freeStore[screenChunk - 1]; ++p)
+                p->next = p + 1;
+            freeStore[screenChunk - 1].next = nullptr;
+        }
+        p = freeStore;
+        freeStore = freeStore->next;
+        return p;
+    }
+
+    void operator delete(void *ptr)
+    {
+        Screen *p = reinterpret_cast<Screen *>(ptr);
+        p->next = freeStore;
+        freeStore = p;
+    }
+
+private:
+    Screen *next;
+    static inline Screen *freeStore = nullptr;
+    static const int screenChunk = 24;
+
+private:
+    int id;
+};
+
+// ==================== 4_perClassAllocator2 ====================
+class Airplane
+{
+private:
+    struct AirplaneRep
+    {
+        unsigned long miles;
+        char type;
+    };
+
+private:
+    union
+    {
+        AirplaneRep rep; // 针对使用中的object
+        Airplane *next;  // 针对在free list中的object
+    };
+
+public:
+    static void *operator new(size_t size)
+    {
+        if (size != sizeof(Airplane))
+            return ::operator new(size);
+        Airplane *p = headOfFreeList;
+        if (p)
+            headOfFreeList = p->next;
+        else
+        {
+            Airplane *newBlock = static_cast<Airplane *>(::operator new(BLOCK_SIZE * sizeof(Airplane)));
+            for (int i = 1; i < BLOCK_SIZE - 1; ++i)
+                newBlock[i].next = &newBlock[i + 1];
+            newBlock[BLOCK_SIZE - 1].next = nullptr;
+            p = newBlock;
+            headOfFreeList = &newBlock[1];
+        }
+        return p;
+    }
+    static void operator delete(void *deadObject, size_t size)
+    {
+        if (deadObject == nullptr)
+            return;
+        if (size != sizeof(Airplane))
+        {
+            ::operator delete(deadObject);
+            return;
+        }
+        Airplane *p = static_cast<Airplane *>(deadObject);
+        p->next = headOfFreeList;
+        headOfFreeList = p;
+    }
+
+private:
+    static const int BLOCK_SIZE = 512;
+    static inline Airplane *headOfFreeList = nullptr;
+};
+
+// ==================== 5_staticAllocator ====================
+class Allocator
+{
+private:
+    struct obj
+    {
+        struct obj *next;
+    };
+
+public:
+    void *allocate(size_t size)
+    {
+        obj *p;
+        if (!freeStore)
+        {
+            size_t chunk = CHUNK * size;
+            freeStore = p = (obj *)malloc(chunk);
+            for (int i = 0; i < CHUNK - 1; ++i)
+            {
+                p->next = (obj *)((char *)p + size);
+                p = p->next;
+            }
+            p->next = nullptr;
+        }
+        p = freeStore;
+        freeStore = freeStore->next;
+        return p;
+    }
+    void deallocate(void *ptr, size_t size)
+    {
+        ((obj *)ptr)->next = freeStore;
+        freeStore = (obj *)ptr;
+    }
+
+private:
+    obj *freeStore = nullptr;
+    const int CHUNK = 5;
+};
+
+// ==================== 统一接口 ====================
+struct MallocAdapter
+{
+    static const char *name() { return "malloc"; }
+    static constexpr bool anySize = true;
+    static constexpr bool threadSafe = true;
+    static void *allocate(size_t n) { return malloc(n); }
+    static void deallocate(void *p, size_t) { free(p); }
+};
+
+struct OperatorNewAdapter
+{
+    static const char *name() { return "::operator new"; }
+    static constexpr bool anySize = true;
+    static constexpr bool threadSafe = true;
+    static void *allocate(size_t n) { return ::operator new(n); }
+    static void deallocate(void *p, size_t n) { ::operator delete(p, n); }
+};
+
+// 以char为元素类型，n就是字节数
+template <typename Alloc>
+struct StdAllocatorAdapter
+{
+    static constexpr bool anySize = true;
+    static void *allocate(size_t n) { return a.allocate(n); }
+    static void deallocate(void *p, size_t n) { a.deallocate(static_cast<char *>(p), n); }
+    static inline Alloc a;
+};
+
+struct StdAllocator : StdAllocatorAdapter<std::allocator<char>>
+{
+    static const char *name() { return "std::allocator"; }
+    static constexpr bool threadSafe = true;
+};
+
+#ifdef __GNUC__
+struct GnuPoolAlloc : StdAllocatorAdapter<__gnu_cxx::__pool_alloc<char>>
+{
+    static const char *name() { return "__pool_alloc"; }
+    static constexpr bool threadSafe = true; // 内部有mutex
+};
+#endif
+
+// 10_stdAllocImpl：G2.9 alloc的两个版本
+struct G29Alloc
+{
+    static const char *name() { return "G2.9 alloc"; }
+    static constexpr bool anySize = true;
+    static constexpr bool threadSafe = true;
+    static void *allocate(size_t n) { return alloc::allocate(n); }
+    static void deallocate(void *p, size_t n) { alloc::deallocate(p, n); }
+};
+
+struct G29SingleClient
+{
+    static const char *name() { return "G2.9 single"; }
+    static constexpr bool anySize = true;
+    static constexpr bool threadSafe = false;
+    static void *allocate(size_t n) { return single_client_alloc::allocate(n); }
+    static void deallocate(void *p, size_t n) { single_client_alloc::deallocate(p, n); }
+};
+
+struct ScreenAdapter
+{
+    static const char *name() { return "Screen"; }
+    static constexpr bool anySize = false;
+    static constexpr bool threadSafe = false;
+    static void *allocate(size_t) { return Screen::operator new(sizeof(Screen)); }
+    static void deallocate(void *p, size_t) { Screen::operator delete(p); }
+};
+
+struct AirplaneAdapter
+{
+    static const char *name() { return "Airplane"; }
+    static constexpr bool anySize = false;
+    static constexpr bool threadSafe = false;
+    static void *allocate(size_t) { return Airplane::operator new(sizeof(Airplane)); }
+    static void deallocate(void *p, size_t) { Airplane::operator delete(p, sizeof(Airplane)); }
+};
+
+struct AllocatorAdapter
+{
+    static const char *name() { return "Allocator"; }
+    static constexpr bool anySize = false;
+    static constexpr bool threadSafe = false;
+    static void *allocate(size_t) { return a.allocate(BLOCK); }
+    static void deallocate(void *p, size_t) { a.deallocate(p, BLOCK); }
+    static inline Allocator a;
+};
+
+// 11_trimmablePool/12_adaptiveChunkSize
+struct ChunkPoolAdapter
+{
+    static const char *name() { return "ChunkPool"; }
+    static constexpr bool anySize = false;
+    static constexpr bool threadSafe = false;
+    static void *allocate(size_t) { return pool().allocate(); }
+    static void deallocate(void *p, size_t) { pool().deallocate(p); }
+    static ChunkPool &pool()
+    {
+        static ChunkPool p(BLOCK, alignof(void *), 64, 65536);
+        return p;
+    }
+};
+
+// 9_threadCacheAllocator
+struct ThreadCacheAdapter
+{
+    static const char *name() { return "ThreadCache"; }
+    static constexpr bool anySize = false;
+    static constexpr bool threadSafe = true;
+    static void *allocate(size_t) { return get().allocate(BLOCK); }
+    static void deallocate(void *p, size_t) { get().deallocate(p, BLOCK); }
+    static ThreadCacheAllocator &get()
+    {
+        static ThreadCacheAllocator a;
+        return a;
+    }
+};
+
+static_assert(sizeof(Screen) == BLOCK || sizeof(void *) != 8, "Screen is expected to be 16 bytes on 64-bit");
+static_assert(sizeof(Airplane) == BLOCK || sizeof(void *) != 8, "Airplane is expected to be 16 bytes on 64-bit");
+
+template <typename A>
+struct AllocatorTag
+{
+    typedef A type;
+};
+
+// 对类型列表中的每个分配器调用f(AllocatorTag<A>())，f可以是泛型lambda：
+//   AllAllocators::forEach([](auto tag) { typedef typename decltype(tag)::type A; ... });
+template <typename... As>
+struct AllocatorList
+{
+    template <typename F>
+    static void forEach(F &&f)
+    {
+        (f(AllocatorTag<As>()), ...);
+    }
+};
+
+#ifdef __GNUC__
+typedef AllocatorList<MallocAdapter, OperatorNewAdapter, StdAllocator, GnuPoolAlloc, G29Alloc, G29SingleClient,
+                      ScreenAdapter, AirplaneAdapter, AllocatorAdapter, ChunkPoolAdapter, ThreadCacheAdapter>
+    AllAllocators;
+#else
+typedef AllocatorList<MallocAdapter, OperatorNewAdapter, StdAllocator, G29Alloc, G29SingleClient,
+                      ScreenAdapter, AirplaneAdapter, AllocatorAdapter, ChunkPoolAdapter, ThreadCacheAdapter>
+    AllAllocators;
+#endif
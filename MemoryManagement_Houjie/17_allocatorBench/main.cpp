@@ -0,0 +1,271 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstring>
+#ifdef __linux__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#include "../11_trimmablePool/rss.hpp"
+#include "allocators.hpp"
+using namespace std;
+
+// 各分配器在标准负载下的基准测试：
+//   17_allocatorBench [--n=100000] [--repeat=3] [--format=table|csv|json]
+enum Workload
+{
+    LIFO,     // 分配N个，逆序释放
+    FIFO,     // 分配N个，按分配顺序释放
+    RANDOM,   // 分配N个，随机顺序释放
+    MIXED,    // 大小在[8,512]之间随机，随机顺序释放(只测能分配任意大小的分配器)
+    PRODCONS, // 一个线程分配、另一个线程释放(只测线程安全的分配器)
+    WORKLOADS
+};
+const char *workloadName[WORKLOADS] = {"lifo", "fifo", "random", "mixed", "prodcons"};
+
+struct Config
+{
+    size_t n = 100000;
+    int repeat = 3;
+    string format = "table";
+};
+
+struct Measure
+{
+    double nsPerOp; // 一次分配或一次释放算一个op
+    long rssKB;     // 第一轮中全部块都分配出去时，RSS比开始前增长了多少
+};
+
+struct Result
+{
+    string allocator;
+    string workload;
+    Measure m;
+};
+
+// 事先生成好的释放顺序和大小，所有分配器用同一份
+vector<size_t> freeOrder, mixedSizes;
+
+// 每个块写一个字节，保证页真的被用到
+inline void touch(void *p) { *static_cast<volatile char *>(p) = 1; }
+
+template <typename A>
+double producerConsumer(size_t N, long *rss)
+{
+    const size_t CAP = 1024;
+    vector<void *> q(CAP);
+    atomic<size_t> head{0}, tail{0};
+    long base = rss ? rssKB() : 0;
+    auto start = chrono::steady_clock::now();
+    thread consumer([&]
+                    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            size_t t = tail.load(memory_order_relaxed);
+            while (head.load(memory_order_acquire) == t)
+                this_thread::yield();
+            void *p = q[t % CAP];
+            tail.store(t + 1, memory_order_release);
+            A::deallocate(p, BLOCK);
+        } });
+    for (size_t i = 0; i < N; ++i)
+    {
+        void *p = A::allocate(BLOCK);
+        touch(p);
+        size_t h = head.load(memory_order_relaxed);
+        while (h - tail.load(memory_order_acquire) >= CAP)
+            this_thread::yield();
+        q[h % CAP] = p;
+        head.store(h + 1, memory_order_release);
+    }
+    consumer.join();
+    chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+    if (rss)
+        *rss = rssKB() - base; // 同时存活的块不超过CAP个，这里看的是分配器留下了多少
+    return d.count();
+}
+
+// 返回一轮的耗时(ns)；rss不为空时，在分配阶段结束后(不计时)记下RSS增长了多少
+template <typename A>
+double runOnce(Workload w, size_t N, long *rss)
+{
+    if (w == PRODCONS)
+        return producerConsumer<A>(N, rss);
+
+    vector<void *> v(N);
+    long base = rss ? rssKB() : 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < N; ++i)
+    {
+        v[i] = A::allocate(w == MIXED ? mixedSizes[i] : BLOCK);
+        touch(v[i]);
+    }
+    chrono::duration<double, nano> allocTime = chrono::steady_clock::now() - start;
+    if (rss)
+        *rss = rssKB() - base;
+    start = chrono::steady_clock::now();
+    switch (w)
+    {
+    case LIFO:
+        for (size_t i = N; i-- > 0;)
+            A::deallocate(v[i], BLOCK);
+        break;
+    case FIFO:
+        for (size_t i = 0; i < N; ++i)
+            A::deallocate(v[i], BLOCK);
+        break;
+    case RANDOM:
+        for (size_t i = 0; i < N; ++i)
+            A::deallocate(v[freeOrder[i]], BLOCK);
+        break;
+    default:
+        for (size_t i = 0; i < N; ++i)
+            A::deallocate(v[freeOrder[i]], mixedSizes[freeOrder[i]]);
+        break;
+    }
+    chrono::duration<double, nano> freeTime = chrono::steady_clock::now() - start;
+    return allocTime.count() + freeTime.count();
+}
+
+// 跑repeat轮取最快的一轮；第一轮包含了分配器向系统要内存的开销
+template <typename A>
+Measure measure(Workload w, const Config &cfg)
+{
+    rssKB(); // 预热：第一次用ifstream读/proc要初始化locale和缓冲区，RSS增长约100多KB，不计入基线
+    long rss = 0;
+    double best = runOnce<A>(w, cfg.n, &rss);
+    for (int r = 1; r < cfg.repeat; ++r)
+        best = min(best, runOnce<A>(w, cfg.n, nullptr));
+    return {best / (2 * cfg.n), rss};
+}
+
+// Linux上每个(分配器, 负载)在fork出的子进程中运行：
+// Screen、Airplane等从不把内存还给系统，放在同一个进程里前一项会影响后一项的RSS和缓存状态
+template <typename A>
+Measure isolated(Workload w, const Config &cfg)
+{
+#ifdef __linux__
+    int fds[2];
+    if (pipe(fds) == 0)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(fds[0]);
+            Measure m = measure<A>(w, cfg);
+            ssize_t r = write(fds[1], &m, sizeof(m));
+            _exit(r == sizeof(m) ? 0 : 1);
+        }
+        close(fds[1]);
+        Measure m{0, 0};
+        ssize_t r = pid > 0 ? read(fds[0], &m, sizeof(m)) : -1;
+        close(fds[0]);
+        if (pid > 0)
+            waitpid(pid, nullptr, 0);
+        if (r == sizeof(m))
+            return m;
+    }
+#endif
+    return measure<A>(w, cfg);
+}
+
+void printTable(const vector<Result> &results)
+{
+    cout << left << setw(16) << "allocator" << setw(10) << "workload" << right
+         << setw(10) << "ns/op" << setw(12) << "Mops/s" << setw(12) << "RSS(KB)" << endl;
+    string last;
+    for (const Result &r : results)
+    {
+        if (!last.empty() && r.allocator != last)
+            cout << endl;
+        last = r.allocator;
+        cout << left << setw(16) << r.allocator << setw(10) << r.workload << right << fixed
+             << setw(10) << setprecision(2) << r.m.nsPerOp
+             << setw(12) << setprecision(1) << 1e3 / r.m.nsPerOp
+             << setw(12) << r.m.rssKB << endl;
+    }
+}
+
+void printCsv(const vector<Result> &results, const Config &cfg)
+{
+    cout << "allocator,workload,n,ns_per_op,ops_per_sec,rss_kb" << endl;
+    for (const Result &r : results)
+        cout << r.allocator << "," << r.workload << "," << cfg.n << "," << fixed << setprecision(3)
+             << r.m.nsPerOp << "," << setprecision(0) << 1e9 / r.m.nsPerOp << "," << r.m.rssKB << endl;
+}
+
+void printJson(const vector<Result> &results, const Config &cfg)
+{
+    cout << "{\n  \"compiler\": \"" <<
+#ifdef __VERSION__
+        __VERSION__
+#else
+        "unknown"
+#endif
+         << "\",\n  \"n\": " << cfg.n << ",\n  \"repeat\": " << cfg.repeat
+         << ",\n  \"block_bytes\": " << BLOCK << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result &r = results[i];
+        cout << "    {\"allocator\": \"" << r.allocator << "\", \"workload\": \"" << r.workload
+             << "\", \"ns_per_op\": " << fixed << setprecision(3) << r.m.nsPerOp
+             << ", \"ops_per_sec\": " << setprecision(0) << 1e9 / r.m.nsPerOp
+             << ", \"rss_kb\": " << r.m.rssKB << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    cout << "  ]\n}" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    Config cfg;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg.rfind("--n=", 0) == 0)
+            cfg.n = stoul(arg.substr(4));
+        else if (arg.rfind("--repeat=", 0) == 0)
+            cfg.repeat = max(1, stoi(arg.substr(9)));
+        else if (arg.rfind("--format=", 0) == 0)
+            cfg.format = arg.substr(9);
+        else
+        {
+            cerr << "usage: " << argv[0] << " [--n=100000] [--repeat=3] [--format=table|csv|json]" << endl;
+            return 1;
+        }
+    }
+
+    mt19937 rng(42);
+    freeOrder.resize(cfg.n);
+    mixedSizes.resize(cfg.n);
+    for (size_t i = 0; i < cfg.n; ++i)
+    {
+        freeOrder[i] = i;
+        mixedSizes[i] = 8 + rng() % 505;
+    }
+    shuffle(freeOrder.begin(), freeOrder.end(), rng);
+
+    vector<Result> results;
+    AllAllocators::forEach([&](auto tag)
+                           {
+        typedef typename decltype(tag)::type A;
+        for (int w = 0; w < WORKLOADS; ++w)
+        {
+            if ((w == MIXED && !A::anySize) || (w == PRODCONS && !A::threadSafe))
+                continue;
+            results.push_back({A::name(), workloadName[w], isolated<A>(Workload(w), cfg)});
+        } });
+
+    if (cfg.format == "csv")
+        printCsv(results, cfg);
+    else if (cfg.format == "json")
+        printJson(results, cfg);
+    else
+        printTable(results);
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstring>
+#if defined(__linux__) || defined(_WIN32)
+#include <malloc.h> // malloc_usable_size / _msize
+#endif
+#ifdef __linux__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#include "../11_trimmablePool/rss.hpp"
+#include "../17_allocatorBench/allocators.hpp"
+using namespace std;
+
+// 把8_G2.9std_alloc...中的cookie_test推广：对每个分配器、每个大小分配K个块，测量
+//   stride：相邻两块地址之差(取众数)，即每块实际占用的地址空间
+//   slot  ：分配器为这一块预留的可用字节(malloc系用malloc_usable_size，池就是stride)
+//   pad   ：slot - size，向上取整造成的内部碎片
+//   header：stride - slot，块头(cookie)等
+//   rss   ：分配K个块后RSS的增长 / K，包括分配器向系统多要而还没用上的内存
+//   18_allocOverhead [--csv]
+
+const size_t K = 20000;
+const size_t SIZES[] = {8, 16, 24, 32, 48, 64, 96, 128, 192, 256, 512, 1024};
+
+// 块来自malloc时才能对它调用malloc_usable_size：
+// malloc系的分配器全部如此；G2.9 alloc和__pool_alloc超过MAX_BYTES(128)的请求转交给malloc
+template <typename A>
+struct MallocBacked
+{
+    static bool of(size_t) { return false; }
+};
+template <>
+struct MallocBacked<MallocAdapter>
+{
+    static bool of(size_t) { return true; }
+};
+template <>
+struct MallocBacked<OperatorNewAdapter>
+{
+    static bool of(size_t) { return true; }
+};
+template <>
+struct MallocBacked<StdAllocator>
+{
+    static bool of(size_t) { return true; }
+};
+template <>
+struct MallocBacked<G29Alloc>
+{
+    static bool of(size_t size) { return size > MAX_BYTES; }
+};
+template <>
+struct MallocBacked<G29SingleClient>
+{
+    static bool of(size_t size) { return size > MAX_BYTES; }
+};
+#ifdef __GNUC__
+template <>
+struct MallocBacked<GnuPoolAlloc>
+{
+    static bool of(size_t size) { return size > MAX_BYTES; }
+};
+#endif
+
+size_t usableSize(void *p)
+{
+#if defined(__linux__)
+    return malloc_usable_size(p);
+#elif defined(_WIN32)
+    return _msize(p);
+#else
+    return 0;
+#endif
+}
+
+struct Overhead
+{
+    long stride;
+    double slot;
+    double rssPerBlock; // 没有RSS数据时为0
+};
+
+struct Row
+{
+    string allocator;
+    size_t size;
+    Overhead o;
+};
+
+template <typename A>
+Overhead analyze(size_t size)
+{
+    vector<char *> v(K);
+    // 预热：analyze在fork出的子进程中运行，子进程第一次读statm时ifstream的缓冲区等要分配、写时复制，
+    // RSS多出约128KB，与K个块无关，先读一次再取基线
+    rssKB();
+    long before = rssKB();
+    for (size_t i = 0; i < K; ++i)
+    {
+        v[i] = static_cast<char *>(A::allocate(size));
+        memset(v[i], 0, size);
+    }
+    long after = rssKB();
+
+    double usable = 0;
+    bool mallocBacked = MallocBacked<A>::of(size);
+    if (mallocBacked)
+        for (char *p : v)
+            usable += usableSize(p);
+
+    // 相邻地址之差的众数：池按chunk切，chunk之间的间隔只占少数
+    vector<char *> sorted(v);
+    sort(sorted.begin(), sorted.end());
+    map<long, size_t> diffs;
+    for (size_t i = 1; i < K; ++i)
+        ++diffs[sorted[i] - sorted[i - 1]];
+    long stride = max_element(diffs.begin(), diffs.end(),
+                              [](const pair<const long, size_t> &a, const pair<const long, size_t> &b)
+                              { return a.second < b.second; })
+                      ->first;
+
+    for (size_t i = 0; i < K; ++i)
+        A::deallocate(v[i], size);
+
+    double slot = mallocBacked && usable > 0 ? usable / K : double(stride);
+    return {stride, slot, (after - before) * 1024.0 / K};
+}
+
+// Linux上在子进程中分析，每一项都从干净的堆开始
+template <typename A>
+Overhead isolated(size_t size)
+{
+#ifdef __linux__
+    int fds[2];
+    if (pipe(fds) == 0)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(fds[0]);
+            Overhead o = analyze<A>(size);
+            ssize_t r = write(fds[1], &o, sizeof(o));
+            _exit(r == sizeof(o) ? 0 : 1);
+        }
+        close(fds[1]);
+        Overhead o{};
+        ssize_t r = pid > 0 ? read(fds[0], &o, sizeof(o)) : -1;
+        close(fds[0]);
+        if (pid > 0)
+            waitpid(pid, nullptr, 0);
+        if (r == sizeof(o))
+            return o;
+    }
+#endif
+    return analyze<A>(size);
+}
+
+int main(int argc, char *argv[])
+{
+    bool csv = argc > 1 && string(argv[1]) == "--csv";
+
+    vector<Row> rows;
+    AllAllocators::forEach([&](auto tag)
+                           {
+        typedef typename decltype(tag)::type A;
+        for (size_t size : SIZES)
+            if (A::anySize || size == BLOCK)
+                rows.push_back({A::name(), size, isolated<A>(size)}); });
+
+    if (csv)
+    {
+        cout << "allocator,size,stride,slot,pad,header,rss_per_block" << endl;
+        for (const Row &r : rows)
+            cout << r.allocator << "," << r.size << "," << r.o.stride << "," << r.o.slot << ","
+                 << r.o.slot - r.size << "," << r.o.stride - r.o.slot << "," << r.o.rssPerBlock << endl;
+        return 0;
+    }
+
+    // 1. 每个分配器、每个大小
+    cout << left << setw(16) << "allocator" << right << setw(6) << "size" << setw(8) << "stride"
+         << setw(8) << "slot" << setw(8) << "pad" << setw(8) << "header" << setw(10) << "rss/blk"
+         << setw(10) << "waste%" << endl;
+    string last;
+    for (const Row &r : rows)
+    {
+        if (!last.empty() && r.allocator != last)
+            cout << endl;
+        last = r.allocator;
+        double waste = r.o.rssPerBlock > 0 ? (1 - r.size / r.o.rssPerBlock) * 100 : 0;
+        cout << left << setw(16) << r.allocator << right << fixed << setprecision(0) << setw(6) << r.size
+             << setw(8) << r.o.stride << setw(8) << r.o.slot << setw(8) << r.o.slot - r.size
+             << setw(8) << r.o.stride - r.o.slot << setw(10) << setprecision(1) << r.o.rssPerBlock
+             << setw(10) << waste << endl;
+    }
+
+    // 2. 每个大小最省内存的分配器(按rss/blk，没有RSS数据时按stride)
+    cout << "\ncheapest per size:" << endl;
+    for (size_t size : SIZES)
+    {
+        const Row *best = nullptr;
+        for (const Row &r : rows)
+        {
+            if (r.size != size)
+                continue;
+            double cost = r.o.rssPerBlock > 0 ? r.o.rssPerBlock : r.o.stride;
+            double bestCost = best ? (best->o.rssPerBlock > 0 ? best->o.rssPerBlock : best->o.stride) : 0;
+            if (!best || cost < bestCost)
+                best = &r;
+        }
+        if (best)
+            cout << setw(6) << size << " B: " << best->allocator << " (" << setprecision(1)
+                 << (best->o.rssPerBlock > 0 ? best->o.rssPerBlock : best->o.stride) << " B/block)" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include "monotonicArena.hpp"
+using namespace std;
+
+class A
+{
+public:
+    int id;
+    A(int i) : id(i) { cout << "ctor. this = " << this << " id = " << id << endl; }
+    ~A() { cout << "dtor. this = " << this << " id = " << id << endl; }
+};
+
+// 64字节对齐的对象，例如按cache line对齐的计数器
+struct alignas(64) CacheLine
+{
+    long value[8];
+};
+
+// 一次"请求"中要分配的小对象
+struct Node
+{
+    Node *next;
+    int key;
+    double weight;
+};
+
+const size_t REQUESTS = 2000;
+const size_t NODES_PER_REQUEST = 500;
+
+// 1. 每个对象单独new/delete
+double benchNewDelete()
+{
+    vector<Node *> v(NODES_PER_REQUEST);
+    long sum = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t r = 0; r < REQUESTS; ++r)
+    {
+        for (size_t i = 0; i < NODES_PER_REQUEST; ++i)
+            v[i] = new Node{i ? v[i - 1] : nullptr, int(i), 1.0};
+        sum += v[NODES_PER_REQUEST - 1]->key;
+        for (size_t i = 0; i < NODES_PER_REQUEST; ++i)
+            delete v[i];
+    }
+    chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+    return sum ? d.count() / (REQUESTS * NODES_PER_REQUEST) : 0;
+}
+
+// 2. 同样的对象放在arena中，请求结束时reset一次
+double benchArena()
+{
+    MonotonicArena arena;
+    vector<Node *> v(NODES_PER_REQUEST);
+    long sum = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t r = 0; r < REQUESTS; ++r)
+    {
+        for (size_t i = 0; i < NODES_PER_REQUEST; ++i)
+            v[i] = arena.create<Node>(Node{i ? v[i - 1] : nullptr, int(i), 1.0});
+        sum += v[NODES_PER_REQUEST - 1]->key;
+        arena.reset();
+    }
+    chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+    return sum ? d.count() / (REQUESTS * NODES_PER_REQUEST) : 0;
+}
+
+// 3. 标准库的对应物：std::pmr::monotonic_buffer_resource，release()后会把block还给上游
+double benchPmr()
+{
+    pmr::monotonic_buffer_resource res;
+    vector<Node *> v(NODES_PER_REQUEST);
+    long sum = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t r = 0; r < REQUESTS; ++r)
+    {
+        for (size_t i = 0; i < NODES_PER_REQUEST; ++i)
+            v[i] = new (res.allocate(sizeof(Node), alignof(Node))) Node{i ? v[i - 1] : nullptr, int(i), 1.0};
+        sum += v[NODES_PER_REQUEST - 1]->key;
+        res.release();
+    }
+    chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+    return sum ? d.count() / (REQUESTS * NODES_PER_REQUEST) : 0;
+}
+
+int main()
+{
+    // Test 1: 1_memoryPrimitives中的Test 4，换成arena
+    // 缓冲区放在栈上，对象的析构函数登记在arena中，reset时逆序调用，不用再手工调用~A()
+    {
+        cout << "--- Test 1: placement new into an arena ---" << endl;
+        alignas(max_align_t) char buf[256];
+        MonotonicArena arena(buf, sizeof(buf));
+        A *pa = arena.create<A>(1);
+        A *pb = arena.create<A>(2);
+        A *pc = arena.create<A>(3);
+        cout << "pa->id=" << pa->id << " pb->id=" << pb->id << " pc->id=" << pc->id << endl;
+        cout << "bytesUsed=" << arena.bytesUsed() << " heapBlocks=" << arena.heapBlocks() << endl;
+        arena.reset();
+        cout << "after reset: bytesUsed=" << arena.bytesUsed() << endl;
+    }
+
+    // Test 2: 对齐。先分配1个字节把指针弄乱，再要alignas(64)的对象
+    {
+        cout << "--- Test 2: alignment ---" << endl;
+        MonotonicArena arena;
+        for (int i = 0; i < 3; ++i)
+        {
+            char *c = arena.create<char>('x');
+            CacheLine *line = arena.create<CacheLine>();
+            double *d = arena.allocateArray<double>(3);
+            cout << "char " << static_cast<void *>(c) << "  CacheLine " << line
+                 << " (%64=" << reinterpret_cast<uintptr_t>(line) % 64 << ")"
+                 << "  double[3] " << d << " (%8=" << reinterpret_cast<uintptr_t>(d) % alignof(double) << ")" << endl;
+        }
+    }
+
+    // Test 3: block链和复用。第一轮向堆要了若干block，reset后第二轮全部复用，不再向堆要
+    {
+        cout << "--- Test 3: chained blocks ---" << endl;
+        MonotonicArena arena(256, 4096);
+        for (int round = 0; round < 2; ++round)
+        {
+            for (int i = 0; i < 200; ++i)
+                arena.allocate(48);
+            cout << "round " << round << ": bytesUsed=" << arena.bytesUsed()
+                 << " bytesReserved=" << arena.bytesReserved() << " heapBlocks=" << arena.heapBlocks() << endl;
+            arena.reset();
+        }
+        void *big = arena.allocate(100000); // 超过上限的请求单独给一块
+        cout << "big " << big << " heapBlocks=" << arena.heapBlocks() << endl;
+        arena.release();
+        cout << "after release: bytesReserved=" << arena.bytesReserved() << " heapBlocks=" << arena.heapBlocks() << endl;
+    }
+
+    // Test 4: 请求级别的分配，每个请求分配NODES_PER_REQUEST个对象，请求结束全部释放
+    {
+        cout << "--- Test 4: request-scoped allocation (ns/object) ---" << endl;
+        double best[3] = {1e9, 1e9, 1e9};
+        for (int r = 0; r < 3; ++r)
+        {
+            best[0] = min(best[0], benchNewDelete());
+            best[1] = min(best[1], benchArena());
+            best[2] = min(best[2], benchPmr());
+        }
+        cout << fixed << setprecision(2);
+        cout << left << setw(32) << "new/delete" << right << setw(8) << best[0] << endl;
+        cout << left << setw(32) << "MonotonicArena + reset" << right << setw(8) << best[1] << endl;
+        cout << left << setw(32) << "pmr::monotonic_buffer_resource" << right << setw(8) << best[2] << endl;
+    }
+    return 0;
+}
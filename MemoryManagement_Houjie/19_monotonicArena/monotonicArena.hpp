@@ -0,0 +1,211 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 单调(bump pointer)arena：把1_memoryPrimitives Test 4中"在char缓冲区上placement new"的做法做成分配器
+// 1. 分配只是把指针往后挪(按对齐要求先取整)，不记录单个对象，也不能单独释放；
+// 2. 当前block用完就向系统要下一个，block串成链表，大小按2倍增长到上限；
+// 3. reset()一次性"释放"所有对象：指针退回第一个block，block全部保留给下一轮复用，
+//    没有登记析构函数时是O(1)的；
+// 4. 需要析构的对象可以登记析构函数，reset()/析构时按构造的逆序调用。
+class MonotonicArena
+{
+private:
+    struct Block
+    {
+        Block *next;
+        size_t size; // 含Block头
+        bool owned;  // false：用户提供的初始缓冲区，不归arena释放
+    };
+
+    // 析构函数登记，本身也分配在arena中
+    struct DtorNode
+    {
+        void (*destroy)(void *);
+        void *obj;
+        DtorNode *prev;
+    };
+
+public:
+    // blockBytes：第一个堆block的大小；maxBlockBytes：block增长的上限
+    explicit MonotonicArena(size_t blockBytes = 4096, size_t maxBlockBytes = 1 << 20)
+        : nextBlockBytes(blockBytes < MIN_BLOCK ? MIN_BLOCK : blockBytes),
+          maxBlockBytes(maxBlockBytes < nextBlockBytes ? nextBlockBytes : maxBlockBytes)
+    {
+    }
+
+    // 先用调用者提供的缓冲区(例如栈上的char数组)，用完再向堆要
+    MonotonicArena(void *buffer, size_t bytes, size_t blockBytes = 4096, size_t maxBlockBytes = 1 << 20)
+        : MonotonicArena(blockBytes, maxBlockBytes)
+    {
+        char *b = alignUp(static_cast<char *>(buffer), alignof(Block));
+        if (buffer && b + sizeof(Block) < static_cast<char *>(buffer) + bytes)
+        {
+            head = tail = current = new (b) Block{nullptr, size_t(static_cast<char *>(buffer) + bytes - b), false};
+            cur = b + sizeof(Block);
+            end = b + head->size;
+            reserved = head->size;
+        }
+    }
+
+    ~MonotonicArena() { release(); }
+
+    MonotonicArena(const MonotonicArena &) = delete;
+    MonotonicArena &operator=(const MonotonicArena &) = delete;
+
+    // align必须是2的幂
+    void *allocate(size_t bytes, size_t align = alignof(std::max_align_t))
+    {
+        char *p = alignUp(cur, align);
+        if (cur && size_t(p - cur) + bytes <= size_t(end - cur))
+        {
+            cur = p + bytes;
+            used += bytes;
+            return p;
+        }
+        return allocateSlow(bytes, align);
+    }
+
+    // 构造一个T；T需要析构时登记它的析构函数
+    template <typename T, typename... Args>
+    T *create(Args &&...args)
+    {
+        if constexpr (std::is_trivially_destructible<T>::value)
+            return createUnmanaged<T>(std::forward<Args>(args)...);
+        else
+        {
+            // 先分配登记节点，构造函数抛异常时最多浪费一个节点
+            DtorNode *node = static_cast<DtorNode *>(allocate(sizeof(DtorNode), alignof(DtorNode)));
+            T *obj = createUnmanaged<T>(std::forward<Args>(args)...);
+            node->destroy = [](void *p)
+            { static_cast<T *>(p)->~T(); };
+            node->obj = obj;
+            node->prev = dtors;
+            dtors = node;
+            return obj;
+        }
+    }
+
+    // 构造一个T，不登记析构函数(调用者保证不需要析构，或自己负责)
+    template <typename T, typename... Args>
+    T *createUnmanaged(Args &&...args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // 未初始化的T数组
+    template <typename T>
+    T *allocateArray(size_t n)
+    {
+        return static_cast<T *>(allocate(sizeof(T) * n, alignof(T)));
+    }
+
+    // 调用登记过的析构函数，回到第一个block，block全部留着复用
+    void reset()
+    {
+        runDestructors();
+        current = head;
+        cur = head ? reinterpret_cast<char *>(head) + sizeof(Block) : nullptr;
+        end = head ? reinterpret_cast<char *>(head) + head->size : nullptr;
+        used = 0;
+    }
+
+    // reset并把所有堆block还给系统
+    void release()
+    {
+        runDestructors();
+        Block *keep = nullptr;
+        for (Block *b = head; b;)
+        {
+            Block *next = b->next;
+            if (b->owned)
+                ::operator delete(b);
+            else
+                keep = b;
+            b = next;
+        }
+        head = tail = current = keep;
+        if (keep)
+            keep->next = nullptr;
+        reserved = keep ? keep->size : 0;
+        blocks = 0;
+        cur = keep ? reinterpret_cast<char *>(keep) + sizeof(Block) : nullptr;
+        end = keep ? reinterpret_cast<char *>(keep) + keep->size : nullptr;
+        used = 0;
+    }
+
+    size_t bytesUsed() const { return used; }         // 自上次reset以来请求的字节数
+    size_t bytesReserved() const { return reserved; } // 所有block的总大小
+    size_t heapBlocks() const { return blocks; }      // 向堆要的block个数
+
+private:
+    static const size_t MIN_BLOCK = 256;
+
+    static char *alignUp(char *p, size_t align)
+    {
+        return reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(p) + align - 1) & ~uintptr_t(align - 1));
+    }
+
+    void *allocateSlow(size_t bytes, size_t align)
+    {
+        // 先看reset后留下来的block能不能装下，装不下的跳过(本轮浪费，下次reset再用)
+        while (current && current->next)
+        {
+            current = current->next;
+            cur = reinterpret_cast<char *>(current) + sizeof(Block);
+            end = reinterpret_cast<char *>(current) + current->size;
+            char *p = alignUp(cur, align);
+            if (size_t(p - cur) + bytes <= size_t(end - cur))
+            {
+                cur = p + bytes;
+                used += bytes;
+                return p;
+            }
+        }
+
+        // 新block：至少是nextBlockBytes，超大请求单独给一块刚好够用的
+        size_t need = sizeof(Block) + bytes + align;
+        size_t size = need > nextBlockBytes ? need : nextBlockBytes;
+        Block *b = new (::operator new(size)) Block{nullptr, size, true};
+        if (tail)
+            tail->next = b;
+        else
+            head = b;
+        tail = current = b;
+        reserved += size;
+        ++blocks;
+        if (nextBlockBytes < maxBlockBytes)
+            nextBlockBytes = nextBlockBytes * 2 < maxBlockBytes ? nextBlockBytes * 2 : maxBlockBytes;
+
+        char *p = alignUp(reinterpret_cast<char *>(b) + sizeof(Block), align);
+        cur = p + bytes;
+        end = reinterpret_cast<char *>(b) + size;
+        used += bytes;
+        return p;
+    }
+
+    void runDestructors()
+    {
+        // 后构造的先析构
+        while (dtors)
+        {
+            DtorNode *n = dtors;
+            dtors = n->prev;
+            n->destroy(n->obj);
+        }
+    }
+
+private:
+    char *cur = nullptr; // 当前block中下一个可用字节
+    char *end = nullptr; // 当前block的末尾
+    Block *head = nullptr, *tail = nullptr, *current = nullptr;
+    DtorNode *dtors = nullptr;
+    size_t nextBlockBytes;
+    size_t maxBlockBytes;
+    size_t used = 0;
+    size_t reserved = 0;
+    size_t blocks = 0;
+};
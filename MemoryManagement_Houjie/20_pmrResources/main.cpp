@@ -0,0 +1,127 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <list>
+#include <forward_list>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <memory_resource>
+#include "pmrResources.hpp"
+using namespace std;
+
+// 包在upstream外面，统计有多少请求漏到了upstream
+class CountingResource : public pmr::memory_resource
+{
+public:
+    explicit CountingResource(pmr::memory_resource *upstream = pmr::new_delete_resource()) : upstream(upstream) {}
+    size_t allocations = 0;
+    size_t bytes = 0;
+
+private:
+    void *do_allocate(size_t n, size_t align) override
+    {
+        ++allocations;
+        bytes += n;
+        return upstream->allocate(n, align);
+    }
+    void do_deallocate(void *p, size_t n, size_t align) override { upstream->deallocate(p, n, align); }
+    bool do_is_equal(const pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    pmr::memory_resource *upstream;
+};
+
+const size_t N = 100000;
+
+// list<int>尾部插入N个、再从头部逐个删除，几乎只有节点的分配和释放；返回每个op的ns
+double benchList(pmr::memory_resource *r)
+{
+    double best = 1e300;
+    for (int round = 0; round < 5; ++round)
+    {
+        pmr::list<int> l(r);
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < N; ++i)
+            l.push_back(int(i));
+        while (!l.empty())
+            l.pop_front();
+        chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+        best = min(best, d.count() / (2 * N));
+    }
+    return best;
+}
+
+int main()
+{
+    // Test 1: pmr::vector<pmr::string>，vector的数组和每个string的缓冲区都来自同一个分级池
+    {
+        cout << "--- Test 1: pmr::vector<pmr::string> on SizeClassPoolResource ---" << endl;
+        CountingResource upstream;
+        SizeClassPoolResource pool(&upstream);
+        {
+            pmr::vector<pmr::string> names(&pool);
+            for (int i = 0; i < 1000; ++i)
+                names.emplace_back("customer-" + to_string(i * 7919) + "-with-a-long-name");
+            SizeClassPoolResource::Stats s = pool.getStats();
+            cout << "strings=" << names.size() << " pooledBlocks=" << s.pooledBlocks << " largeBlocks=" << s.largeBlocks
+                 << " chunks=" << s.chunks << " upstream allocations=" << upstream.allocations << endl;
+            cout << "names[1].get_allocator().resource() == &pool: " << boolalpha
+                 << (names[1].get_allocator().resource() == &pool) << endl;
+        }
+        cout << "after destroy: pooledBlocks=" << pool.getStats().pooledBlocks
+             << " reservedBytes=" << pool.getStats().reservedBytes << endl;
+    }
+
+    // Test 2: 各容器的节点分别放进5_staticAllocator、G2.9 alloc、Screen、Airplane的池
+    {
+        cout << "--- Test 2: containers on the chapter pools ---" << endl;
+        CountingResource upstream;
+
+        AllocatorResource<32> allocatorRes(&upstream); // list<int>的节点是24字节
+        pmr::list<int> l(&allocatorRes);
+        for (int i = 0; i < 1000; ++i)
+            l.push_back(i);
+
+        G29AllocResource g29Res(&upstream);
+        pmr::map<int, int> m(&g29Res);
+        for (int i = 0; i < 1000; ++i)
+            m[i] = i;
+
+        ScreenResource screenRes(&upstream); // forward_list<int>的节点是16字节，正好是一个Screen
+        AirplaneResource airplaneRes(&upstream);
+        pmr::forward_list<int> f1(&screenRes), f2(&airplaneRes);
+        for (int i = 0; i < 1000; ++i)
+        {
+            f1.push_front(i);
+            f2.push_front(i);
+        }
+
+        cout << "list=" << l.size() << " map=" << m.size() << " forward_list=" << distance(f1.begin(), f1.end())
+             << "+" << distance(f2.begin(), f2.end()) << " upstream allocations=" << upstream.allocations << endl;
+
+        // 节点放不进定长池时交给upstream：list<string>的节点远大于32字节
+        pmr::list<pmr::string> big(&allocatorRes);
+        big.emplace_back("x");
+        cout << "list<pmr::string> node: upstream allocations=" << upstream.allocations << endl;
+    }
+
+    // Test 3: 同一段pmr::list<int>代码换不同的memory_resource
+    {
+        cout << "--- Test 3: pmr::list<int> push_back+pop_front (ns/op) ---" << endl;
+        G29AllocResource g29Res;
+        AllocatorResource<32> allocatorRes;
+        ScreenResource screenRes; // 节点放不下，全部交给upstream，相当于多一层转发
+        SizeClassPoolResource sizeClass;
+        pmr::unsynchronized_pool_resource stdPool;
+
+        cout << fixed << setprecision(2);
+        cout << left << setw(32) << "new_delete_resource" << right << setw(8) << benchList(pmr::new_delete_resource()) << endl;
+        cout << left << setw(32) << "G29AllocResource" << right << setw(8) << benchList(&g29Res) << endl;
+        cout << left << setw(32) << "AllocatorResource<32>" << right << setw(8) << benchList(&allocatorRes) << endl;
+        cout << left << setw(32) << "ScreenResource" << right << setw(8) << benchList(&screenRes) << endl;
+        cout << left << setw(32) << "SizeClassPoolResource" << right << setw(8) << benchList(&sizeClass) << endl;
+        cout << left << setw(32) << "unsynchronized_pool_resource" << right << setw(8) << benchList(&stdPool) << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,214 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include "../17_allocatorBench/allocators.hpp"
+
+// 把前面各章的分配器包装成std::pmr::memory_resource，标准容器换成pmr版本就能直接用上这些池：
+//   PoolResource<A>：17_allocatorBench中的静态适配器(G2.9 alloc、Screen、Airplane、Allocator...)
+//   SizeClassPoolResource：按16字节分级的池，每个实例有自己的free list，析构时归还全部chunk
+
+// 5_staticAllocator的Allocator，每种块大小一个static实例
+// (17_allocatorBench中的AllocatorAdapter固定为BLOCK字节，容器的节点通常更大)
+template <size_t N>
+struct StaticAllocator
+{
+    static_assert(N >= sizeof(void *) && N % alignof(void *) == 0, "block must hold a pointer and keep it aligned");
+    static const char *name() { return "Allocator"; }
+    static constexpr bool anySize = false;
+    static constexpr bool threadSafe = false;
+    static void *allocate(size_t) { return a.allocate(N); }
+    static void deallocate(void *p, size_t) { a.deallocate(p, N); }
+    static inline Allocator a;
+};
+
+// A是17_allocatorBench/allocators.hpp格式的静态适配器，Block是它的块大小(anySize时不用)
+// 1. 池能满足的请求(定长池：bytes <= Block；对齐都不超过alignof(void*))交给A，其余交给upstream；
+// 2. 池是static的，同一个A的所有PoolResource共用，只要upstream相等，一个分配的内存另一个也能释放。
+template <typename A, size_t Block = BLOCK>
+class PoolResource : public std::pmr::memory_resource
+{
+public:
+    explicit PoolResource(std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+        : upstream(upstream)
+    {
+    }
+
+    std::pmr::memory_resource *upstreamResource() const { return upstream; }
+
+    static bool handles(size_t bytes, size_t align)
+    {
+        // 定长池按块大小的整数倍切，G2.9 alloc按ALIGN(8)取整，都只保证指针的对齐
+        return align <= alignof(void *) && (A::anySize || bytes <= Block);
+    }
+
+private:
+    void *do_allocate(size_t bytes, size_t align) override
+    {
+        if (handles(bytes, align))
+            return A::allocate(A::anySize ? bytes : Block);
+        return upstream->allocate(bytes, align);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t align) override
+    {
+        if (handles(bytes, align))
+            A::deallocate(p, A::anySize ? bytes : Block);
+        else
+            upstream->deallocate(p, bytes, align);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        const PoolResource *o = dynamic_cast<const PoolResource *>(&other);
+        return o && *o->upstream == *upstream;
+    }
+
+private:
+    std::pmr::memory_resource *upstream;
+};
+
+typedef PoolResource<G29Alloc> G29AllocResource;
+typedef PoolResource<ScreenAdapter> ScreenResource;
+typedef PoolResource<AirplaneAdapter> AirplaneResource;
+template <size_t N>
+using AllocatorResource = PoolResource<StaticAllocator<N>, N>;
+
+// 按大小分级的池，相当于简化版的std::pmr::unsynchronized_pool_resource：
+// 1. 大小按GRANULE(16)向上取整，每一级一条free list，块之间没有cookie；
+// 2. 某一级的free list空了就向upstream要一个chunk切开，每一级的chunk大小从MIN_CHUNK_BLOCKS个块开始
+//    翻倍，直到MAX_CHUNK_BYTES(Allocator的CHUNK固定为5，太小了，见18_allocOverhead)；
+// 3. 超过MAX_BYTES或对齐超过GRANULE的请求直接交给upstream；
+// 4. 不是线程安全的；release()/析构时把所有chunk还给upstream，不管上面还有没有活对象。
+class SizeClassPoolResource : public std::pmr::memory_resource
+{
+private:
+    struct obj
+    {
+        struct obj *next;
+    };
+
+    // 每个chunk开头的头部，串成链表以便release
+    struct alignas(16) ChunkHeader
+    {
+        ChunkHeader *next;
+        size_t bytes;
+    };
+
+public:
+    static const size_t GRANULE = 16;
+    static const size_t MAX_BYTES = 512;
+    static const size_t NCLASSES = MAX_BYTES / GRANULE;
+    static const size_t MIN_CHUNK_BLOCKS = 16;
+    static const size_t MAX_CHUNK_BYTES = 64 * 1024;
+
+    struct Stats
+    {
+        size_t chunks;        // 向upstream要的chunk数
+        size_t reservedBytes; // 这些chunk的总字节数
+        size_t pooledBlocks;  // 从池中分配出去、还没归还的块数
+        size_t largeBlocks;   // 直接交给upstream、还没归还的块数
+    };
+
+    explicit SizeClassPoolResource(std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+        : upstream(upstream)
+    {
+    }
+
+    ~SizeClassPoolResource() { release(); }
+
+    SizeClassPoolResource(const SizeClassPoolResource &) = delete;
+    SizeClassPoolResource &operator=(const SizeClassPoolResource &) = delete;
+
+    void release()
+    {
+        while (chunks)
+        {
+            ChunkHeader *c = chunks;
+            chunks = c->next;
+            upstream->deallocate(c, c->bytes, alignof(ChunkHeader));
+        }
+        for (size_t i = 0; i < NCLASSES; ++i)
+        {
+            freeList[i] = nullptr;
+            nextChunkBlocks[i] = 0;
+        }
+        stats = Stats{};
+    }
+
+    std::pmr::memory_resource *upstreamResource() const { return upstream; }
+    Stats getStats() const { return stats; }
+
+private:
+    static size_t classIndex(size_t bytes) { return bytes ? (bytes - 1) / GRANULE : 0; }
+
+    void *do_allocate(size_t bytes, size_t align) override
+    {
+        if (bytes > MAX_BYTES || align > GRANULE)
+        {
+            void *p = upstream->allocate(bytes, align);
+            ++stats.largeBlocks;
+            return p;
+        }
+        size_t i = classIndex(bytes);
+        if (!freeList[i])
+            refill(i);
+        obj *p = freeList[i];
+        freeList[i] = p->next;
+        ++stats.pooledBlocks;
+        return p;
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t align) override
+    {
+        if (bytes > MAX_BYTES || align > GRANULE)
+        {
+            upstream->deallocate(p, bytes, align);
+            --stats.largeBlocks;
+            return;
+        }
+        size_t i = classIndex(bytes);
+        obj *q = static_cast<obj *>(p);
+        q->next = freeList[i];
+        freeList[i] = q;
+        --stats.pooledBlocks;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    // 给第i级要一个新chunk，切成块挂到free list上
+    void refill(size_t i)
+    {
+        size_t size = (i + 1) * GRANULE;
+        size_t n = nextChunkBlocks[i] ? nextChunkBlocks[i] : MIN_CHUNK_BLOCKS;
+        if (size * n * 2 <= MAX_CHUNK_BYTES)
+            nextChunkBlocks[i] = n * 2;
+        else
+            nextChunkBlocks[i] = n;
+
+        size_t bytes = sizeof(ChunkHeader) + size * n;
+        ChunkHeader *c = static_cast<ChunkHeader *>(upstream->allocate(bytes, alignof(ChunkHeader)));
+        c->next = chunks;
+        c->bytes = bytes;
+        chunks = c;
+        ++stats.chunks;
+        stats.reservedBytes += bytes;
+
+        char *p = reinterpret_cast<char *>(c + 1);
+        for (size_t k = 0; k < n; ++k, p += size)
+        {
+            obj *o = reinterpret_cast<obj *>(p);
+            o->next = k + 1 < n ? reinterpret_cast<obj *>(p + size) : freeList[i];
+        }
+        freeList[i] = reinterpret_cast<obj *>(c + 1);
+    }
+
+private:
+    std::pmr::memory_resource *upstream;
+    obj *freeList[NCLASSES] = {};
+    size_t nextChunkBlocks[NCLASSES] = {};
+    ChunkHeader *chunks = nullptr;
+    Stats stats{};
+};
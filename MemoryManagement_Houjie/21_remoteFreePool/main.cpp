@@ -0,0 +1,258 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+#include "remoteFreePool.hpp"
+using namespace std;
+
+// 4_perClassAllocator2的Airplane，operator new/delete改用RemoteFreePool
+class Airplane
+{
+private:
+    struct AirplaneRep
+    {
+        unsigned long miles;
+        char type;
+    };
+
+private:
+    AirplaneRep rep;
+
+public:
+    Airplane(unsigned long m, char t) : rep{m, t} {}
+    unsigned long getMiles() const { return rep.miles; }
+    char getType() const { return rep.type; }
+
+    static void *operator new(size_t size)
+    {
+        // 继承发生时size可能不等于Airplane的大小
+        if (size != sizeof(Airplane))
+            return ::operator new(size);
+        return RemoteFreePool<sizeof(Airplane)>::allocate();
+    }
+    static void operator delete(void *deadObject, size_t size)
+    {
+        if (size != sizeof(Airplane))
+        {
+            ::operator delete(deadObject);
+            return;
+        }
+        RemoteFreePool<sizeof(Airplane)>::deallocate(deadObject);
+    }
+};
+
+typedef RemoteFreePool<sizeof(Airplane)> AirplanePool;
+
+// ==================== 对照组，块大小都是16字节 ====================
+struct obj
+{
+    obj *next;
+};
+
+// 1. 原来的全局free list加一把锁，最直接的"线程安全"改法
+struct MutexPool
+{
+    static const char *name() { return "global list + mutex"; }
+    static void *allocate()
+    {
+        lock_guard<mutex> lock(mtx);
+        if (!head)
+            carve();
+        obj *p = head;
+        head = p->next;
+        return p;
+    }
+    static void deallocate(void *p)
+    {
+        lock_guard<mutex> lock(mtx);
+        static_cast<obj *>(p)->next = head;
+        head = static_cast<obj *>(p);
+    }
+    static void carve()
+    {
+        char *block = static_cast<char *>(::operator new(CHUNK * 16));
+        chunks.push_back(block);
+        for (int i = 0; i < CHUNK; ++i)
+            reinterpret_cast<obj *>(block + i * 16)->next = i + 1 < CHUNK ? reinterpret_cast<obj *>(block + (i + 1) * 16) : nullptr;
+        head = reinterpret_cast<obj *>(block);
+    }
+    static long reservedKB() { return long(chunks.size() * CHUNK * 16 / 1024); }
+
+    static const int CHUNK = 512;
+    static inline mutex mtx;
+    static inline obj *head = nullptr;
+    static inline vector<void *> chunks;
+};
+
+// 2. 每个线程一条free list，谁释放就挂到谁的list上：不加锁，但内存从分配线程"迁移"到释放线程
+struct LocalOnlyPool
+{
+    static const char *name() { return "thread-local lists"; }
+    static void *allocate()
+    {
+        if (!head)
+            carve();
+        obj *p = head;
+        head = p->next;
+        return p;
+    }
+    static void deallocate(void *p)
+    {
+        static_cast<obj *>(p)->next = head;
+        head = static_cast<obj *>(p);
+    }
+    static void carve()
+    {
+        char *block = static_cast<char *>(::operator new(CHUNK * 16));
+        {
+            lock_guard<mutex> lock(mtx);
+            chunks.push_back(block);
+        }
+        for (int i = 0; i < CHUNK; ++i)
+            reinterpret_cast<obj *>(block + i * 16)->next = i + 1 < CHUNK ? reinterpret_cast<obj *>(block + (i + 1) * 16) : nullptr;
+        head = reinterpret_cast<obj *>(block);
+    }
+    static long reservedKB()
+    {
+        lock_guard<mutex> lock(mtx);
+        return long(chunks.size() * CHUNK * 16 / 1024);
+    }
+
+    static const int CHUNK = 512;
+    static inline thread_local obj *head = nullptr;
+    static inline mutex mtx;
+    static inline vector<void *> chunks;
+};
+
+// 3. malloc
+struct MallocPool
+{
+    static const char *name() { return "malloc"; }
+    static void *allocate() { return malloc(16); }
+    static void deallocate(void *p) { free(p); }
+    static long reservedKB() { return -1; } // 不统计
+};
+
+// 4. RemoteFreePool
+struct RemotePool
+{
+    static const char *name() { return "RemoteFreePool"; }
+    static void *allocate() { return AirplanePool::allocate(); }
+    static void deallocate(void *p) { AirplanePool::deallocate(p); }
+    static long reservedKB() { return long(AirplanePool::stats().slabs * AirplanePool::SLAB_BYTES / 1024); }
+};
+
+// 摄取线程分配对象，经过一个CAP格的无锁队列交给工作线程销毁；返回每个对象的ns
+template <typename P>
+double pipeline(size_t n)
+{
+    const size_t CAP = 1024;
+    vector<void *> q(CAP);
+    atomic<size_t> head{0}, tail{0};
+    atomic<size_t> bad{0};
+    auto start = chrono::steady_clock::now();
+    thread worker([&]
+                  {
+        for (size_t i = 0; i < n; ++i)
+        {
+            size_t t = tail.load(memory_order_relaxed);
+            while (head.load(memory_order_acquire) == t)
+                this_thread::yield();
+            void *p = q[t % CAP];
+            tail.store(t + 1, memory_order_release);
+            if (*static_cast<size_t *>(p) != i)
+                bad.fetch_add(1);
+            P::deallocate(p);
+        } });
+    for (size_t i = 0; i < n; ++i)
+    {
+        void *p = P::allocate();
+        *static_cast<size_t *>(p) = i;
+        size_t h = head.load(memory_order_relaxed);
+        while (h - tail.load(memory_order_acquire) >= CAP)
+            this_thread::yield();
+        q[h % CAP] = p;
+        head.store(h + 1, memory_order_release);
+    }
+    worker.join();
+    chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+    if (bad.load())
+        cout << "corrupted objects: " << bad.load() << endl;
+    return d.count() / n;
+}
+
+template <typename P>
+void runPipeline(size_t n)
+{
+    long before = P::reservedKB();
+    double ns = pipeline<P>(n);
+    long grown = P::reservedKB() - before;
+    cout << left << setw(24) << P::name() << right << fixed << setprecision(2) << setw(10) << ns << setw(12);
+    if (before < 0)
+        cout << "-" << endl;
+    else
+        cout << grown << endl;
+}
+
+int main()
+{
+    cout << "sizeof(Airplane) = " << sizeof(Airplane) << endl;
+
+    // Test 1: 4个线程各自new一批Airplane，再交换：每个线程delete下一个线程new出来的对象
+    {
+        cout << "--- Test 1: every delete is a remote free ---" << endl;
+        const int T = 4;
+        const size_t N = 100000;
+        vector<vector<Airplane *>> planes(T, vector<Airplane *>(N));
+        atomic<int> ready{0};
+        atomic<size_t> bad{0};
+        vector<thread> threads;
+        for (int t = 0; t < T; ++t)
+            threads.emplace_back([&, t]
+                                 {
+                for (size_t i = 0; i < N; ++i)
+                    planes[t][i] = new Airplane(t * N + i, 'A' + t);
+                ready.fetch_add(1);
+                while (ready.load() < T)
+                    this_thread::yield();
+                const vector<Airplane *> &victims = planes[(t + 1) % T];
+                for (size_t i = 0; i < N; ++i)
+                {
+                    Airplane *p = victims[i];
+                    if (p->getMiles() != ((t + 1) % T) * N + i)
+                        bad.fetch_add(1);
+                    delete p;
+                }
+                // 再分配一轮：本地free list是空的，应当整批收回别人还回来的块，而不是要新slab
+                vector<Airplane *> again(N);
+                for (size_t i = 0; i < N; ++i)
+                    again[i] = new Airplane(i, 'B');
+                for (size_t i = 0; i < N; ++i)
+                    delete again[i]; });
+        for (thread &th : threads)
+            th.join();
+        AirplanePool::Stats s = AirplanePool::stats();
+        cout << "corrupted=" << bad.load() << " heaps=" << s.heaps << " slabs=" << s.slabs
+             << " remoteFrees=" << s.remoteFrees << " reclaims=" << s.reclaims << endl;
+    }
+
+    // Test 2: 生产者/消费者流水线
+    {
+        cout << "--- Test 2: ingest thread allocates, worker thread frees ---" << endl;
+        const size_t N = 2000000;
+        cout << left << setw(24) << "pool" << right << setw(10) << "ns/object" << setw(12) << "grown(KB)" << endl;
+        runPipeline<MutexPool>(N);
+        runPipeline<LocalOnlyPool>(N);
+        runPipeline<MallocPool>(N);
+        AirplanePool::Stats before = AirplanePool::stats();
+        runPipeline<RemotePool>(N);
+        AirplanePool::Stats after = AirplanePool::stats();
+        cout << "RemoteFreePool: remoteFrees=" << after.remoteFrees - before.remoteFrees
+             << " reclaims=" << after.reclaims - before.reclaims << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include "../11_trimmablePool/chunkProvider.hpp"
+
+// 支持跨线程释放的定长对象池(每种大小一个，所有成员都是static)
+// 4_perClassAllocator2的Airplane只有一条全局free list，一个线程分配、另一个线程释放就会竞争；
+// 改成每个线程一条free list后，又会出现"内存迁移"：释放线程的free list越攒越长，分配线程只能不停要新内存。
+// 这里的做法(与mimalloc、snmalloc相同)：
+// 1. 每个线程有自己的Heap，Heap从系统要SLAB_BYTES对齐的slab，slab头部记录所属的Heap(owner)；
+// 2. 本线程释放自己的块：放回本地free list，不需要任何同步；
+// 3. 释放别的线程的块：地址按SLAB_BYTES取整找到slab，用一次CAS挂到owner的remote list上(无锁，多生产者)；
+// 4. owner的本地free list空了，先用一次exchange把remote list整条摘下来，批量收回，不够再切slab；
+// 5. 线程退出时Heap进入空闲表，下一个新线程接手，slab和之后的远程释放都不会丢。
+// slab通过ChunkProvider(见11_trimmablePool)要，来源是第一次分配时的ChunkProvider::getDefault()。
+template <size_t SIZE>
+class RemoteFreePool
+{
+private:
+    struct obj
+    {
+        struct obj *next;
+    };
+
+    struct Heap;
+
+    struct Slab
+    {
+        Heap *owner; // 创建后不再改变
+        Slab *next;
+    };
+
+    struct Heap
+    {
+        // 只有owner线程访问
+        obj *localFree = nullptr;
+        char *bumpCur = nullptr; // 当前slab中还没切过的部分，按需切，不一次性碰完整个slab
+        char *bumpEnd = nullptr;
+        Slab *slabs = nullptr;
+        // 只有owner写；用atomic是为了stats()可以在别的线程读
+        std::atomic<size_t> slabCount{0};
+        std::atomic<size_t> reclaims{0}; // 从remote list批量收回的次数
+        Heap *nextIdle = nullptr;
+        Heap *nextAll = nullptr;
+
+        // 其他线程访问，单独占一个cache line，不和owner的字段伪共享
+        alignas(64) std::atomic<obj *> remoteFree{nullptr};
+        std::atomic<size_t> remoteFrees{0};
+    };
+
+    // 线程退出时把Heap放回空闲表，只在第一次取得Heap时构造
+    struct HeapOwner
+    {
+        ~HeapOwner()
+        {
+            if (tlsHeap)
+                retireHeap(tlsHeap);
+            tlsHeap = nullptr;
+        }
+    };
+
+public:
+    static const size_t SLAB_BYTES = 64 * 1024;
+    static const size_t BLOCK = SIZE < sizeof(obj) ? sizeof(obj) : (SIZE + alignof(obj) - 1) / alignof(obj) * alignof(obj);
+    static const size_t HEADER = (sizeof(Slab) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+    static_assert(HEADER + BLOCK <= SLAB_BYTES, "object too large for a slab");
+
+    struct Stats
+    {
+        size_t heaps;       // 创建过的Heap数
+        size_t slabs;       // 向系统要的slab数
+        size_t remoteFrees; // 跨线程释放的次数
+        size_t reclaims;    // owner批量收回remote list的次数
+    };
+
+    static void *allocate()
+    {
+        Heap *h = tlsHeap ? tlsHeap : acquireHeap();
+        obj *p = h->localFree;
+        if (p)
+        {
+            h->localFree = p->next;
+            return p;
+        }
+        return refill(h);
+    }
+
+    static void deallocate(void *ptr)
+    {
+        if (!ptr)
+            return;
+        obj *p = static_cast<obj *>(ptr);
+        Heap *owner = slabOf(p)->owner;
+        if (owner == tlsHeap)
+        {
+            p->next = owner->localFree;
+            owner->localFree = p;
+            return;
+        }
+        // 多个线程可能同时往同一个owner推，owner一次取走整条链，所以没有ABA问题
+        obj *head = owner->remoteFree.load(std::memory_order_relaxed);
+        do
+            p->next = head;
+        while (!owner->remoteFree.compare_exchange_weak(head, p, std::memory_order_release, std::memory_order_relaxed));
+        owner->remoteFrees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 只用于观察，线程还在运行时读到的是近似值
+    static Stats stats()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        Stats s{0, 0, 0, 0};
+        for (Heap *h = allHeaps; h; h = h->nextAll)
+        {
+            ++s.heaps;
+            s.slabs += h->slabCount.load(std::memory_order_relaxed);
+            s.remoteFrees += h->remoteFrees.load(std::memory_order_relaxed);
+            s.reclaims += h->reclaims.load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+private:
+    static Slab *slabOf(void *p)
+    {
+        return reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(SLAB_BYTES - 1));
+    }
+
+    static void *refill(Heap *h)
+    {
+        // 1. 把别的线程还回来的块整条收回
+        obj *r = h->remoteFree.exchange(nullptr, std::memory_order_acquire);
+        if (r)
+        {
+            h->reclaims.store(h->reclaims.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            h->localFree = r->next;
+            return r;
+        }
+        // 2. 从当前slab切一块，slab用完再要一个
+        if (size_t(h->bumpEnd - h->bumpCur) < BLOCK)
+            newSlab(h);
+        void *p = h->bumpCur;
+        h->bumpCur += BLOCK;
+        return p;
+    }
+
+    static void newSlab(Heap *h)
+    {
+        Slab *s = static_cast<Slab *>(provider()->allocate(SLAB_BYTES, SLAB_BYTES));
+        s->owner = h;
+        s->next = h->slabs;
+        h->slabs = s;
+        h->slabCount.store(h->slabCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        h->bumpCur = reinterpret_cast<char *>(s) + HEADER;
+        h->bumpEnd = reinterpret_cast<char *>(s) + SLAB_BYTES;
+    }
+
+    // slab从不归还，但所有Heap仍用同一个provider：第一次调用时取默认值，之后setDefault不再影响这个池
+    static ChunkProvider *provider()
+    {
+        static ChunkProvider *p = ChunkProvider::getDefault();
+        return p;
+    }
+
+    static Heap *acquireHeap()
+    {
+        Heap *h;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            h = idleHeaps;
+            if (h)
+                idleHeaps = h->nextIdle;
+            else
+            {
+                h = new Heap;
+                h->nextAll = allHeaps;
+                allHeaps = h;
+            }
+        }
+        static thread_local HeapOwner owner;
+        (void)owner;
+        tlsHeap = h;
+        return h;
+    }
+
+    static void retireHeap(Heap *h)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        h->nextIdle = idleHeaps;
+        idleHeaps = h;
+    }
+
+private:
+    // 平凡类型的thread_local，热路径上访问不需要经过TLS初始化检查
+    static inline thread_local Heap *tlsHeap = nullptr;
+    static inline std::mutex mtx; // 只保护Heap的创建和空闲表
+    static inline Heap *allHeaps = nullptr;
+    static inline Heap *idleHeaps = nullptr;
+};
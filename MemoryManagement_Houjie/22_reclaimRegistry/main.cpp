@@ -0,0 +1,190 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <new>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#include "reclaimRegistry.hpp"
+#include "../10_stdAllocImpl/stdAlloc.hpp"
+#include "../11_trimmablePool/chunkPool.hpp"
+using namespace std;
+
+const size_t MB = 1024 * 1024;
+char *volatile sink; // 防止编译器把成对的new/delete优化掉
+
+// 7_newhandlerAndNothrow中的noMoreMemory，这里作为所有回调都无能为力时的fallback：
+// 不再abort，返回后handler抛出bad_alloc，new(nothrow)就会得到nullptr
+void noMoreMemory()
+{
+    cout << "  Out of memory! nothing left to reclaim" << endl;
+}
+
+// 一个按LRU淘汰的缓存，例如解码后的图片；淘汰后数据要重新计算，所以优先级排在空闲chunk之后
+class ImageCache
+{
+public:
+    explicit ImageCache(size_t capacity) { entries.reserve(capacity); } // 预留好，淘汰时不再分配
+
+    void put(size_t bytes)
+    {
+        char *p = new char[bytes];
+        memset(p, 1, bytes);
+        entries.push_back(Entry{p, bytes});
+    }
+
+    // 淘汰最老的一项，返回释放的字节数
+    size_t evictOldest()
+    {
+        if (entries.empty())
+            return 0;
+        Entry e = entries.front();
+        entries.erase(entries.begin());
+        delete[] e.data;
+        return e.bytes;
+    }
+
+    size_t size() const { return entries.size(); }
+
+    ~ImageCache()
+    {
+        while (evictOldest())
+            ;
+    }
+
+private:
+    struct Entry
+    {
+        char *data;
+        size_t bytes;
+    };
+    vector<Entry> entries;
+};
+
+// 应急储备：启动时先占一块内存，其他办法都用完了才交出来，换取一点时间(例如保存数据后退出)。
+// 只能用一次，回调交出内存后在回调中remove自己
+struct EmergencyReserve
+{
+    char *mem;
+    size_t bytes;
+    int id;
+};
+
+long vmSizeKB()
+{
+#ifdef __linux__
+    ifstream statm("/proc/self/statm");
+    long pages = 0;
+    statm >> pages;
+    return pages * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return 0;
+#endif
+}
+
+// 把地址空间限制在当前大小 + headroom，模拟内存紧张。ASan要预留巨大的shadow内存，不能这样限制
+bool limitAddressSpace(size_t headroom)
+{
+#if defined(__linux__) && !defined(__SANITIZE_ADDRESS__)
+    rlimit r;
+    r.rlim_cur = r.rlim_max = vmSizeKB() * 1024 + headroom;
+    return setrlimit(RLIMIT_AS, &r) == 0;
+#else
+    (void)headroom;
+    return false;
+#endif
+}
+
+int main()
+{
+    // 64字节的对象池，chunk从64KB增长到1MB
+    ChunkPool pool(64, 8, 1024, 16384);
+    ImageCache cache(32);
+
+    // 业务高峰：池里曾经有20万个对象，cache里有16张4MB的图片
+    {
+        vector<void *> objs(200000);
+        for (void *&p : objs)
+            p = pool.allocate();
+        for (void *p : objs)
+            pool.deallocate(p);
+    }
+    for (int i = 0; i < 16; ++i)
+        cache.put(4 * MB);
+    cout << "pool: chunks=" << pool.stats().chunks << " empty=" << pool.stats().emptyChunks
+         << " reserved=" << pool.stats().reservedBytes / 1024 << "KB; cache: " << cache.size() << " x 4MB" << endl;
+
+    // 登记回调：先还空闲chunk(不损失任何东西)，再淘汰缓存(要重新计算)，每次只淘汰一项
+    ReclaimRegistry::add(0, "ChunkPool::trim", [](void *p) -> size_t
+                         {
+        size_t bytes = static_cast<ChunkPool *>(p)->trim();
+        cout << "  [reclaim] ChunkPool::trim released " << bytes / 1024 << "KB" << endl;
+        return bytes; }, &pool);
+    ReclaimRegistry::add(10, "ImageCache::evictOldest", [](void *p) -> size_t
+                         {
+        ImageCache *c = static_cast<ImageCache *>(p);
+        size_t bytes = c->evictOldest();
+        cout << "  [reclaim] ImageCache evicted " << bytes / MB << "MB, " << c->size() << " left" << endl;
+        return bytes; }, &cache);
+    EmergencyReserve reserve{static_cast<char *>(malloc(8 * MB)), 8 * MB, -1};
+    memset(reserve.mem, 0, reserve.bytes);
+    reserve.id = ReclaimRegistry::add(20, "EmergencyReserve", [](void *p) -> size_t
+                                      {
+        EmergencyReserve *r = static_cast<EmergencyReserve *>(p);
+        free(r->mem);
+        ReclaimRegistry::remove(r->id); // 回调在登记表的锁之外调用，这里可以remove
+        cout << "  [reclaim] EmergencyReserve released " << r->bytes / MB << "MB and removed itself" << endl;
+        return r->bytes; }, &reserve);
+    ReclaimRegistry::install(noMoreMemory);
+    malloc_alloc::set_malloc_handler(ReclaimRegistry::handler); // G2.9一级配置器的oom_malloc也走同一套
+
+    if (!limitAddressSpace(24 * MB))
+        cout << "(address space not limited on this platform/build, allocations below will simply succeed)" << endl;
+
+    // Test 1: 突发的大请求。原来会进noMoreMemory然后abort；现在先还空闲chunk，还不够再逐项淘汰缓存
+    {
+        cout << "--- Test 1: new char[40MB] under a 24MB headroom ---" << endl;
+        char *p = new char[40 * MB];
+        memset(p, 0, 40 * MB);
+        cout << "succeeded, cache entries left: " << cache.size() << endl;
+        delete[] p;
+    }
+
+    // Test 2: G2.9 alloc超过128字节的请求交给malloc_alloc，malloc失败时的oom_malloc同样先回收
+    {
+        cout << "--- Test 2: alloc::allocate(48MB) ---" << endl;
+        void *p = alloc::allocate(48 * MB);
+        cout << "succeeded, cache entries left: " << cache.size() << endl;
+        alloc::deallocate(p, 48 * MB);
+    }
+
+    // Test 3: 无论如何也满足不了的请求：回收到底，然后nothrow得到nullptr，普通new抛出bad_alloc，程序继续运行
+    {
+        cout << "--- Test 3: new (nothrow) char[1GB] ---" << endl;
+        char *p = new (nothrow) char[1024 * MB];
+        cout << "nothrow new returned " << (p ? "memory" : "nullptr") << endl;
+        delete[] p;
+        try
+        {
+            sink = new char[1024 * MB];
+            delete[] sink;
+        }
+        catch (const bad_alloc &e)
+        {
+            cout << "new threw " << e.what() << endl;
+        }
+        void *m = ReclaimRegistry::tryMalloc(1024 * MB);
+        cout << "tryMalloc returned " << (m ? "memory" : "nullptr") << endl;
+        free(m);
+    }
+
+    ReclaimRegistry::EntryStats s[ReclaimRegistry::MAX_ENTRIES];
+    int n = ReclaimRegistry::stats(s, ReclaimRegistry::MAX_ENTRIES);
+    cout << "--- reclaim stats ---" << endl;
+    for (int i = 0; i < n; ++i)
+        cout << s[i].priority << " " << s[i].name << ": calls=" << s[i].calls
+             << " released=" << s[i].releasedBytes / 1024 << "KB" << endl;
+    return 0;
+}
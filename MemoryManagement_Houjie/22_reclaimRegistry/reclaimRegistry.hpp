@@ -0,0 +1,181 @@
+#pragma once
+#include <cstddef>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+// 内存不足时的协作回收
+// 7_newhandlerAndNothrow中的noMoreMemory直接abort，可是这时各个池里往往还攥着空闲的chunk。
+// 这里的做法：池、缓存把"释放一些内存"的回调登记到ReclaimRegistry，安装的new_handler被调用时
+// 1. 按优先级(数字小的先)依次调用回调，第一个真正释放了内存的回调之后就返回，让operator new重试；
+// 2. 重试还失败，operator new会再次调用handler，已经释放干净的回调返回0，于是轮到下一个；
+// 3. 所有回调都释放不出内存时才调用fallback(默认抛出bad_alloc，也可以是原来的noMoreMemory)。
+// new(nothrow)、G2.9 malloc_alloc的oom_malloc、以及tryMalloc()都走同一个handler/reclaimOnce()，
+// 分配失败前都会先回收；nothrow版本在全部回收仍不够时返回nullptr，而不是终止程序。
+class ReclaimRegistry
+{
+public:
+    // 回调：尽量释放内存，返回释放的字节数；必须不分配内存，也不能抛异常。
+    // 回调在表的锁之外调用，里面可以add/remove(包括remove自己)
+    typedef size_t (*Callback)(void *ctx);
+
+    static const int MAX_ENTRIES = 32;
+
+    struct EntryStats
+    {
+        const char *name;
+        int priority;
+        size_t calls;         // 被调用的次数
+        size_t releasedBytes; // 累计释放的字节数
+    };
+
+    // 登记一个回调，返回id(用于remove)；表满时返回-1。表是定长的，登记本身不分配内存
+    static int add(int priority, const char *name, Callback cb, void *ctx)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (count == MAX_ENTRIES)
+            return -1;
+        // 按优先级插入，相同优先级先登记的在前
+        int i = count;
+        while (i > 0 && entries[i - 1].priority > priority)
+        {
+            entries[i] = entries[i - 1];
+            --i;
+        }
+        entries[i] = Entry{nextId, priority, name, cb, ctx, 0, 0};
+        ++count;
+        return nextId++;
+    }
+
+    // remove返回后回调不会再被调用：别的线程正在调用它时，等它返回。
+    // 所以池可以在析构函数中先remove，再释放ctx指向的对象
+    static void remove(int id)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        int i = find(id);
+        if (i < 0)
+            return;
+        for (int j = i; j + 1 < count; ++j)
+            entries[j] = entries[j + 1];
+        --count;
+        // 回调自己remove自己时running也是id，不能等自己
+        if (!reclaiming)
+            idle.wait(lock, [id]
+                      { return running != id; });
+    }
+
+    // 按优先级调用回调，直到有一个释放了内存；返回释放的字节数，0表示已经无可回收
+    static size_t reclaimOnce()
+    {
+        // 回调里如果又分配失败，不能再进来(也会死锁)，直接当作无可回收
+        if (reclaiming)
+            return 0;
+        reclaiming = true;
+        // 同一时刻只有一个线程在回收；表的锁只在取条目、记统计时持有，调用回调时不持有，
+        // 否则回调中add/remove会死锁
+        std::lock_guard<std::mutex> serial(reclaimMtx);
+        Entry snapshot[MAX_ENTRIES];
+        int n;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            n = count;
+            for (int i = 0; i < n; ++i)
+                snapshot[i] = entries[i];
+        }
+        size_t bytes = 0;
+        for (int i = 0; i < n && bytes == 0; ++i)
+        {
+            {
+                // 拷贝之后可能已经被remove，这时ctx可能已经失效，跳过
+                std::lock_guard<std::mutex> lock(mtx);
+                if (find(snapshot[i].id) < 0)
+                    continue;
+                running = snapshot[i].id;
+            }
+            bytes = snapshot[i].cb(snapshot[i].ctx);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                running = -1;
+                int k = find(snapshot[i].id);
+                if (k >= 0)
+                {
+                    ++entries[k].calls;
+                    entries[k].releasedBytes += bytes;
+                }
+            }
+            idle.notify_all();
+        }
+        reclaiming = false;
+        return bytes;
+    }
+
+    // 作为new_handler(或G2.9 malloc_alloc的oom handler)使用
+    static void handler()
+    {
+        if (reclaimOnce() > 0)
+            return; // operator new会重试
+        if (fallback)
+            fallback();
+        throw std::bad_alloc();
+    }
+
+    // 安装handler；fallback在无可回收时调用，可以abort，也可以返回(此时抛出bad_alloc)
+    static std::new_handler install(void (*onExhausted)() = nullptr)
+    {
+        fallback = onExhausted;
+        return std::set_new_handler(handler);
+    }
+
+    // 不抛异常的malloc：失败时先回收再重试，全部回收仍不够才返回nullptr
+    static void *tryMalloc(size_t n)
+    {
+        for (;;)
+        {
+            void *p = malloc(n);
+            if (p || reclaimOnce() == 0)
+                return p;
+        }
+    }
+
+    // 把统计拷到out中，返回条目数
+    static int stats(EntryStats *out, int max)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        int n = count < max ? count : max;
+        for (int i = 0; i < n; ++i)
+            out[i] = EntryStats{entries[i].name, entries[i].priority, entries[i].calls, entries[i].releasedBytes};
+        return n;
+    }
+
+private:
+    // 调用者持有mtx
+    static int find(int id)
+    {
+        for (int i = 0; i < count; ++i)
+            if (entries[i].id == id)
+                return i;
+        return -1;
+    }
+
+    struct Entry
+    {
+        int id;
+        int priority;
+        const char *name;
+        Callback cb;
+        void *ctx;
+        size_t calls;
+        size_t releasedBytes;
+    };
+
+    static inline std::mutex mtx;       // 保护entries、count、running
+    static inline std::mutex reclaimMtx; // 让回收串行
+    static inline std::condition_variable idle;
+    static inline int running = -1; // 正在被调用的回调的id
+    static inline Entry entries[MAX_ENTRIES] = {};
+    static inline int count = 0;
+    static inline int nextId = 0;
+    static inline void (*fallback)() = nullptr;
+    static inline thread_local bool reclaiming = false;
+};
@@ -0,0 +1,161 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "memoryBudget.hpp"
+#include "../17_allocatorBench/allocators.hpp"
+using namespace std;
+
+// ==================== 2_overloadOperatorNewDelete的全局operator new/delete ====================
+// myAlloc/myFree改为记到当前BudgetScope的预算上
+void *myAlloc(size_t size)
+{
+    void *p = budgetedMalloc(size);
+    if (!p)
+        throw bad_alloc();
+    return p;
+}
+
+void myFree(void *ptr)
+{
+    budgetedFree(ptr);
+}
+
+void *operator new(size_t size) { return myAlloc(size); }
+void *operator new[](size_t size) { return myAlloc(size); }
+void *operator new(size_t size, const nothrow_t &) noexcept { return budgetedMalloc(size); }
+void *operator new[](size_t size, const nothrow_t &) noexcept { return budgetedMalloc(size); }
+void operator delete(void *ptr) noexcept { myFree(ptr); }
+void operator delete[](void *ptr) noexcept { myFree(ptr); }
+void operator delete(void *ptr, size_t) noexcept { myFree(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { myFree(ptr); }
+
+const size_t MB = 1024 * 1024;
+
+MemoryBudget stringBudget("string buffers", 6 * MB, 8 * MB);
+MemoryBudget indexBudget("index", 1 * MB, 2 * MB);
+MemoryBudget poolBudget("Allocator pool", 48 * 1024, 64 * 1024);
+
+void logSoftLimit(MemoryBudget &b, size_t reserved, void *)
+{
+    cout << "  [soft limit] " << b.name() << ": reserved " << reserved << " > soft " << b.softLimit() << " bytes" << endl;
+}
+
+void printStats(MemoryBudget &b)
+{
+    MemoryBudget::Stats s = b.stats();
+    cout << "  " << b.name() << ": reserved=" << s.reserved / 1024 << "KB peak=" << s.peak / 1024
+         << "KB softHits=" << s.softHits << " failures=" << s.failures << endl;
+}
+
+// 记账本身的代价：每个线程做n次charge+release
+double chargeCost(int threads, size_t n, bool perThread)
+{
+    static MemoryBudget bench("bench", 1ull << 40, 1ull << 40);
+    static atomic<size_t> naive{0}; // 对照组：每次都加减同一个全局原子变量
+    auto start = chrono::steady_clock::now();
+    vector<thread> ts;
+    for (int t = 0; t < threads; ++t)
+        ts.emplace_back([=]
+                        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                size_t bytes = 16 + (i & 255);
+                if (perThread)
+                {
+                    bench.tryCharge(bytes);
+                    bench.release(bytes);
+                }
+                else
+                {
+                    naive.fetch_add(bytes, memory_order_relaxed);
+                    naive.fetch_sub(bytes, memory_order_relaxed);
+                }
+            } });
+    for (thread &t : ts)
+        t.join();
+    chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+    return d.count() / (threads * n * 2);
+}
+
+int main()
+{
+    stringBudget.onSoftLimit(logSoftLimit);
+    indexBudget.onSoftLimit(logSoftLimit);
+    poolBudget.onSoftLimit(logSoftLimit);
+
+    // Test 1: 全局operator new。BudgetScope内string的缓冲区都记到stringBudget上
+    {
+        cout << "--- Test 1: global operator new, string buffers <= 8MB ---" << endl;
+        vector<string> lines;
+        lines.reserve(100000); // vector自己的数组不在scope内，不算字符串缓冲区
+        try
+        {
+            BudgetScope scope(stringBudget);
+            for (;;)
+                lines.push_back(string(1000, 'x'));
+        }
+        catch (const bad_alloc &)
+        {
+            cout << "bad_alloc after " << lines.size() << " strings of 1000 bytes" << endl;
+        }
+        printStats(stringBudget);
+        lines.clear();
+        stringBudget.flushThread();
+        cout << "after clear + flushThread:" << endl;
+        printStats(stringBudget);
+    }
+
+    // Test 2: 标准Allocator接口，map的节点记到indexBudget上
+    {
+        cout << "--- Test 2: std::map with BudgetedAllocator, index <= 2MB ---" << endl;
+        typedef BudgetedAllocator<pair<const int, int>> Alloc;
+        map<int, int, less<int>, Alloc> index{Alloc(indexBudget)};
+        int k = 0;
+        try
+        {
+            for (;; ++k)
+                index[k] = k;
+        }
+        catch (const bad_alloc &)
+        {
+            cout << "bad_alloc after " << index.size() << " entries" << endl;
+        }
+        for (int i = 0; i < k; i += 2)
+            index.erase(i);
+        int more = 0;
+        for (; more < k / 2; ++more)
+            index[k + more] = 0; // 删掉一半后额度回来了，又能插入同样多
+        cout << "erased half, inserted " << more << " more, size=" << index.size() << endl;
+        printStats(indexBudget);
+    }
+
+    // Test 3: 5_staticAllocator的Allocator，nothrow版本超额时返回nullptr
+    {
+        cout << "--- Test 3: Allocator with BudgetedPool, pool <= 64KB ---" << endl;
+        static Allocator a;
+        BudgetedPool<Allocator> pool(a, poolBudget);
+        vector<void *> blocks;
+        while (void *p = pool.allocate(16, nothrow))
+            blocks.push_back(p);
+        cout << "nullptr after " << blocks.size() << " blocks of 16 bytes" << endl;
+        for (void *p : blocks)
+            pool.deallocate(p, 16);
+        printStats(poolBudget);
+    }
+
+    // Test 4: 记账的代价
+    {
+        cout << "--- Test 4: accounting cost (ns per charge or release) ---" << endl;
+        const size_t N = 2000000;
+        cout << fixed << setprecision(2);
+        for (int threads : {1, 4})
+            cout << threads << " thread(s): global atomic " << setw(6) << chargeCost(threads, N, false)
+                 << "   per-thread grants " << setw(6) << chargeCost(threads, N, true) << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,337 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include "../9_threadCacheAllocator/slotRegistry.hpp"
+
+// 按子系统划分的内存预算，例如"字符串缓冲区 ≤ 512MB"
+// 1. hardLimit：超过就分配失败(nothrow版本返回nullptr，否则抛出bad_alloc)；
+// 2. softLimit：向上越过时调用回调(记日志、淘汰缓存...)，回落到soft以下后重新生效；
+// 3. 记账要便宜：每个线程先向全局计数器"批发"GRANT字节的额度，之后的分配/释放只加减本线程的额度，
+//    额度用完或攒得太多时才碰一次全局原子变量。代价是全局计数器(reserved)比实际使用量
+//    最多多出 线程数 × 2·GRANT，soft回调也按这个粒度触发；hard limit对reserved是严格的。
+class MemoryBudget
+{
+public:
+    static const int MAX_BUDGETS = 64;   // 进程内最多同时存在的预算数，析构后id可以重用(见SlotRegistry)
+    static const size_t GRANT = 64 * 1024; // 每个线程一次批发的额度
+
+    // 越过softLimit时调用，reserved是此刻的全局计数
+    typedef void (*SoftLimitCallback)(MemoryBudget &budget, size_t reserved, void *ctx);
+
+    struct Stats
+    {
+        size_t reserved; // 已经批发给各线程的字节数(含线程手里还没用掉的额度)
+        size_t peak;     // reserved的峰值
+        size_t softHits; // soft回调触发次数
+        size_t failures; // 因hard limit失败的次数
+    };
+
+    MemoryBudget(const char *name, size_t softLimit, size_t hardLimit)
+        : budgetName(name), soft(softLimit), hard(hardLimit < softLimit ? softLimit : hardLimit), slot(Registry::acquire(this))
+    {
+    }
+
+    // 预算通常是全局对象，析构时各线程手里的额度不再归还
+    ~MemoryBudget() { Registry::release(slot); }
+
+    MemoryBudget(const MemoryBudget &) = delete;
+    MemoryBudget &operator=(const MemoryBudget &) = delete;
+
+    void onSoftLimit(SoftLimitCallback cb, void *ctx = nullptr)
+    {
+        softCb = cb;
+        softCtx = ctx;
+    }
+
+    // 记账n字节，超过hard limit时返回false且不记账
+    bool tryCharge(size_t n)
+    {
+        size_t &g = grant();
+        if (g >= n)
+        {
+            g -= n;
+            return true;
+        }
+        return chargeSlow(n);
+    }
+
+    void release(size_t n)
+    {
+        size_t &g = grant();
+        g += n;
+        // 本线程攒了超过两份额度，还回去一部分，留一份应对接下来的分配
+        if (g > 2 * GRANT)
+        {
+            giveBack(g - GRANT);
+            g = GRANT;
+        }
+    }
+
+    // 把本线程手里的额度全部还给全局计数器，例如线程长时间空闲之前
+    void flushThread()
+    {
+        size_t &g = grant();
+        if (g)
+            giveBack(g);
+        g = 0;
+    }
+
+    const char *name() const { return budgetName; }
+    size_t softLimit() const { return soft; }
+    size_t hardLimit() const { return hard; }
+
+    Stats stats() const
+    {
+        return Stats{reservedBytes.load(std::memory_order_relaxed), peakBytes.load(std::memory_order_relaxed),
+                     softHits.load(std::memory_order_relaxed), failures.load(std::memory_order_relaxed)};
+    }
+
+private:
+    typedef SlotRegistry<MemoryBudget, MAX_BUDGETS> Registry;
+
+    struct Grant
+    {
+        size_t bytes;
+        unsigned gen; // 属于槽位的第几代预算
+    };
+
+    // 线程退出时把手里的额度还给各个预算，只在第一次批发时构造
+    struct GrantOwner
+    {
+        ~GrantOwner()
+        {
+            // 在Registry的锁下进行，预算不会同时在别的线程析构
+            Registry::forEach([](int i, unsigned gen, MemoryBudget *b)
+                              {
+                if (localGrant[i].gen == gen && localGrant[i].bytes)
+                    b->giveBack(localGrant[i].bytes); });
+            for (Grant &g : localGrant)
+                g = Grant{0, 0};
+        }
+    };
+
+    // 本线程手里这个预算的额度。代数不同的是槽位上一个预算留下的，那个预算已经析构，直接清零
+    size_t &grant()
+    {
+        Grant &g = localGrant[slot.id];
+        if (g.gen != slot.gen)
+            g = Grant{0, slot.gen};
+        return g.bytes;
+    }
+
+    bool chargeSlow(size_t n)
+    {
+        static thread_local GrantOwner owner;
+        (void)owner;
+
+        size_t &g = grant();
+        size_t need = n - g;
+        size_t cur = reservedBytes.load(std::memory_order_relaxed);
+        size_t ask;
+        for (;;)
+        {
+            // 先比较剩余额度再相加：n可能接近SIZE_MAX，need + GRANT、cur + ask都会回绕
+            if (cur > hard || need > hard - cur)
+            {
+                failures.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            // 正常情况多批发一份GRANT；接近hard limit时只要刚好够用的部分
+            ask = hard - cur - need >= GRANT ? need + GRANT : need;
+            if (reservedBytes.compare_exchange_weak(cur, cur + ask, std::memory_order_relaxed))
+                break;
+        }
+        g = g + ask - n;
+
+        size_t now = cur + ask;
+        size_t peak = peakBytes.load(std::memory_order_relaxed);
+        while (now > peak && !peakBytes.compare_exchange_weak(peak, now, std::memory_order_relaxed))
+            ;
+        if (now > soft && !softFired.exchange(true, std::memory_order_relaxed))
+        {
+            softHits.fetch_add(1, std::memory_order_relaxed);
+            if (softCb)
+                softCb(*this, now, softCtx);
+        }
+        return true;
+    }
+
+    void giveBack(size_t n)
+    {
+        size_t now = reservedBytes.fetch_sub(n, std::memory_order_relaxed) - n;
+        if (now <= soft)
+            softFired.store(false, std::memory_order_relaxed);
+    }
+
+private:
+    const char *budgetName;
+    size_t soft, hard;
+    Registry::Slot slot;
+    SoftLimitCallback softCb = nullptr;
+    void *softCtx = nullptr;
+    std::atomic<size_t> reservedBytes{0};
+    std::atomic<size_t> peakBytes{0};
+    std::atomic<size_t> softHits{0};
+    std::atomic<size_t> failures{0};
+    std::atomic<bool> softFired{false};
+
+    // 平凡类型的thread_local，热路径上访问不需要经过TLS初始化检查
+    static inline thread_local Grant localGrant[MAX_BUDGETS] = {};
+};
+
+// ==================== 包装1：标准Allocator接口 ====================
+// BudgetedAllocator<T>套在std::allocator外面，也可以套在10_stdAllocImpl的StdAlloc<T>外面
+template <typename T, typename Base = std::allocator<T>>
+class BudgetedAllocator
+{
+public:
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef BudgetedAllocator<U, typename std::allocator_traits<Base>::template rebind_alloc<U>> other;
+    };
+
+    explicit BudgetedAllocator(MemoryBudget &b) noexcept : budget(&b) {}
+    template <typename U, typename B>
+    BudgetedAllocator(const BudgetedAllocator<U, B> &other) noexcept : budget(other.budget), base(other.base) {}
+
+    T *allocate(size_t n)
+    {
+        if (n > SIZE_MAX / sizeof(T) || !budget->tryCharge(n * sizeof(T))) // n * sizeof(T)不能回绕
+            throw std::bad_alloc();
+        try
+        {
+            return base.allocate(n);
+        }
+        catch (...)
+        {
+            budget->release(n * sizeof(T));
+            throw;
+        }
+    }
+
+    void deallocate(T *p, size_t n) noexcept
+    {
+        base.deallocate(p, n);
+        budget->release(n * sizeof(T));
+    }
+
+    template <typename U, typename B>
+    bool operator==(const BudgetedAllocator<U, B> &other) const noexcept { return budget == other.budget && base == other.base; }
+    template <typename U, typename B>
+    bool operator!=(const BudgetedAllocator<U, B> &other) const noexcept { return !(*this == other); }
+
+private:
+    template <typename U, typename B>
+    friend class BudgetedAllocator;
+
+    MemoryBudget *budget;
+    Base base;
+};
+
+// ==================== 包装2：池 ====================
+// 任何有allocate(size_t)/deallocate(void *, size_t)的对象，例如5_staticAllocator的Allocator
+template <typename Pool>
+class BudgetedPool
+{
+public:
+    BudgetedPool(Pool &pool, MemoryBudget &budget) : pool(pool), budget(budget) {}
+
+    void *allocate(size_t n)
+    {
+        void *p = allocate(n, std::nothrow);
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    void *allocate(size_t n, const std::nothrow_t &) noexcept
+    {
+        if (!budget.tryCharge(n))
+            return nullptr;
+        // 池自己也可能失败(抛出bad_alloc或返回nullptr)，都要把记上的额度还回去；
+        // 异常不能穿过noexcept函数，否则直接terminate，在这里转成nullptr
+        void *p = nullptr;
+        try
+        {
+            p = pool.allocate(n);
+        }
+        catch (...)
+        {
+        }
+        if (!p)
+            budget.release(n);
+        return p;
+    }
+
+    void deallocate(void *p, size_t n)
+    {
+        pool.deallocate(p, n);
+        budget.release(n);
+    }
+
+private:
+    Pool &pool;
+    MemoryBudget &budget;
+};
+
+// ==================== 包装3：全局operator new ====================
+// BudgetScope存在期间，本线程的全局new都记到这个预算上(可以嵌套)
+class BudgetScope
+{
+public:
+    explicit BudgetScope(MemoryBudget &b) : prev(active) { active = &b; }
+    ~BudgetScope() { active = prev; }
+    BudgetScope(const BudgetScope &) = delete;
+    BudgetScope &operator=(const BudgetScope &) = delete;
+
+    static MemoryBudget *current() { return active; }
+
+private:
+    MemoryBudget *prev;
+    static inline thread_local MemoryBudget *active = nullptr;
+};
+
+// 给2_overloadOperatorNewDelete那样的全局operator new/delete(myAlloc/myFree)调用：
+// 块前面放一个头，记录记到了哪个预算、记了多少，delete时据此归还(也就是一个cookie)。
+// 超过hard limit或malloc失败时返回nullptr。预算对象必须比记在它上面的内存活得长。
+struct alignas(alignof(std::max_align_t)) BudgetHeader
+{
+    MemoryBudget *budget;
+    size_t size;
+};
+
+inline void *budgetedMalloc(size_t n) noexcept
+{
+    if (n > SIZE_MAX - sizeof(BudgetHeader))
+        return nullptr; // 加上头部会回绕
+    MemoryBudget *b = BudgetScope::current();
+    if (b && !b->tryCharge(n))
+        return nullptr;
+    BudgetHeader *h = static_cast<BudgetHeader *>(malloc(sizeof(BudgetHeader) + n));
+    if (!h)
+    {
+        if (b)
+            b->release(n);
+        return nullptr;
+    }
+    h->budget = b;
+    h->size = n;
+    return h + 1;
+}
+
+inline void budgetedFree(void *p) noexcept
+{
+    if (!p)
+        return;
+    BudgetHeader *h = static_cast<BudgetHeader *>(p) - 1;
+    if (h->budget)
+        h->budget->release(h->size);
+    free(h);
+}
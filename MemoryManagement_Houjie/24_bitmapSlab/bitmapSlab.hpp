@@ -0,0 +1,276 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "../11_trimmablePool/chunkProvider.hpp"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// 用位图管理空位的slab分配器
+// 3_perClassAllocator的Screen为了串free list，每个对象永久多出一个8字节的next；
+// 4_perClassAllocator2的Airplane用union省掉了它，但两者的free list都是LIFO的，
+// 释放顺序一乱，之后分配出的地址就在内存中跳来跳去。这里改为：
+// 1. 对象放在SLAB_BYTES对齐的slab中，slab头部有一个位图，1表示空位，对象本身没有任何元数据；
+// 2. 分配时用tzcnt找到最低的空位，总是先填低地址，活对象保持紧凑，分配顺序就是地址顺序；
+// 3. 释放时地址按SLAB_BYTES取整找到slab，下标 = 偏移 / SIZE；位已经是1就是double free，
+//    不在slot边界上就是非法指针，检查不需要额外的内存；
+// 4. 空slab除保留一个外立即还给系统。
+// slab通过ChunkProvider(见11_trimmablePool)要、还，与ChunkPool一样可以换成别的来源。
+// 默认对齐：能整除SIZE的最大的2的幂，最多alignof(max_align_t)。例如24 -> 8，40 -> 8，12 -> 4，48 -> 16
+constexpr size_t bitmapSlabDefaultAlign(size_t size)
+{
+    return (size & (~size + 1)) < alignof(std::max_align_t) ? (size & (~size + 1)) : alignof(std::max_align_t);
+}
+
+template <size_t SIZE, size_t ALIGN = bitmapSlabDefaultAlign(SIZE)>
+class BitmapSlab
+{
+    static_assert(SIZE > 0, "SIZE must be positive");
+    static_assert(ALIGN > 0 && (ALIGN & (ALIGN - 1)) == 0, "ALIGN must be a power of two");
+    static_assert(SIZE % ALIGN == 0, "SIZE must be a multiple of ALIGN");
+
+public:
+    static const size_t SLAB_BYTES = 64 * 1024;
+
+private:
+    // 头部中位图以外的部分
+    struct Slab;
+    struct SlabBase
+    {
+        Slab *prev, *next;       // partial链表(还有空位的slab)
+        Slab *prevAll, *nextAll; // 全部slab
+        BitmapSlab *owner;
+        uint32_t freeCount;
+        uint32_t hint; // 下标小于hint的字全是0，查找从这里开始
+    };
+
+    static constexpr size_t roundUp(size_t n, size_t a) { return (n + a - 1) / a * a; }
+    static constexpr size_t headerBytes(size_t cap) { return roundUp(sizeof(SlabBase) + (cap + 63) / 64 * 8, ALIGN); }
+    static constexpr size_t computeCapacity()
+    {
+        size_t cap = (SLAB_BYTES - sizeof(SlabBase)) / SIZE;
+        while (headerBytes(cap) + cap * SIZE > SLAB_BYTES)
+            --cap;
+        return cap;
+    }
+
+public:
+    static const size_t CAPACITY = computeCapacity(); // 每个slab的对象数
+    static const size_t WORDS = (CAPACITY + 63) / 64;
+    static const size_t HEADER = headerBytes(CAPACITY);
+
+    struct Stats
+    {
+        size_t slabs;        // 持有的slab数
+        size_t liveObjects;  // 由位图的popcnt算出
+        size_t doubleFrees;  // 检测到的double free次数
+        size_t invalidFrees; // 检测到的非法指针次数
+    };
+
+    BitmapSlab() : provider(ChunkProvider::getDefault()) {}
+    // provider: slab的来源，nullptr表示ChunkProvider::getDefault()
+    explicit BitmapSlab(ChunkProvider *provider) : provider(provider ? provider : ChunkProvider::getDefault()) {}
+    ~BitmapSlab()
+    {
+        // 与ChunkPool相同：只释放完全空闲的slab，仍有活对象的留给操作系统回收
+        for (Slab *s = all; s;)
+        {
+            Slab *next = s->nextAll;
+            if (s->freeCount == CAPACITY)
+                freeSlab(s);
+            s = next;
+        }
+    }
+
+    BitmapSlab(const BitmapSlab &) = delete;
+    BitmapSlab &operator=(const BitmapSlab &) = delete;
+
+    void *allocate()
+    {
+        Slab *s = partial;
+        if (!s)
+            s = newSlab();
+        size_t w = s->hint;
+        while (!s->bits[w])
+            ++w;
+        s->hint = uint32_t(w);
+        size_t bit = ctz(s->bits[w]);
+        s->bits[w] &= s->bits[w] - 1; // 清掉最低的1
+        if (--s->freeCount == 0)
+            unlink(s); // 满了，离开partial链表
+        return reinterpret_cast<char *>(s) + HEADER + (w * 64 + bit) * SIZE;
+    }
+
+    // double free或非法指针时返回false，不修改任何状态
+    // (能识别的非法指针是落在本分配器的slab中、但不在slot边界上的地址，完全无关的指针会读到任意内存)
+    bool tryDeallocate(void *ptr)
+    {
+        if (!ptr)
+            return true;
+        Slab *s = slabOf(ptr);
+        size_t offset = static_cast<char *>(ptr) - reinterpret_cast<char *>(s);
+        if (s->owner != this || offset < HEADER || (offset - HEADER) % SIZE != 0 || (offset - HEADER) / SIZE >= CAPACITY)
+        {
+            ++invalidFrees;
+            return false;
+        }
+        size_t i = (offset - HEADER) / SIZE;
+        uint64_t mask = uint64_t(1) << (i % 64);
+        if (s->bits[i / 64] & mask)
+        {
+            ++doubleFrees;
+            return false;
+        }
+        s->bits[i / 64] |= mask;
+        if (i / 64 < s->hint)
+            s->hint = uint32_t(i / 64);
+        if (s->freeCount++ == 0)
+            pushPartial(s); // 从满变为有空位
+        if (s->freeCount == CAPACITY)
+            releaseEmpty(s);
+        return true;
+    }
+
+    void deallocate(void *ptr)
+    {
+        if (!tryDeallocate(ptr))
+        {
+            fprintf(stderr, "BitmapSlab<%zu>: invalid or double free of %p\n", SIZE, ptr);
+            abort();
+        }
+    }
+
+    Stats stats() const
+    {
+        Stats st{slabCount, 0, doubleFrees, invalidFrees};
+        for (Slab *s = all; s; s = s->nextAll)
+        {
+            size_t freeBits = 0;
+            for (size_t w = 0; w < WORDS; ++w)
+                freeBits += popcount(s->bits[w]);
+            st.liveObjects += CAPACITY - freeBits;
+        }
+        return st;
+    }
+
+private:
+    struct Slab : SlabBase
+    {
+        uint64_t bits[WORDS];
+    };
+    static_assert(sizeof(Slab) <= HEADER, "bitmap must fit in the header");
+
+    static Slab *slabOf(void *p)
+    {
+        return reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(SLAB_BYTES - 1));
+    }
+
+    static size_t ctz(uint64_t x)
+    {
+#if defined(__GNUC__)
+        return __builtin_ctzll(x); // 有BMI1时编译成tzcnt(-mbmi或-march=native)，否则是bsf
+#elif defined(_MSC_VER)
+        unsigned long i;
+        _BitScanForward64(&i, x);
+        return i;
+#else
+        size_t i = 0;
+        while (!(x & 1))
+        {
+            x >>= 1;
+            ++i;
+        }
+        return i;
+#endif
+    }
+
+    static size_t popcount(uint64_t x)
+    {
+#if defined(__GNUC__)
+        return __builtin_popcountll(x);
+#elif defined(_MSC_VER)
+        return __popcnt64(x);
+#else
+        size_t n = 0;
+        for (; x; x &= x - 1)
+            ++n;
+        return n;
+#endif
+    }
+
+    Slab *newSlab()
+    {
+        Slab *s = static_cast<Slab *>(provider->allocate(SLAB_BYTES, SLAB_BYTES));
+        s->owner = this;
+        s->freeCount = uint32_t(CAPACITY);
+        s->hint = 0;
+        for (size_t w = 0; w < WORDS; ++w)
+            s->bits[w] = ~uint64_t(0);
+        if (CAPACITY % 64)
+            s->bits[WORDS - 1] = (uint64_t(1) << (CAPACITY % 64)) - 1; // 超出CAPACITY的位不能分配
+        s->prevAll = nullptr;
+        s->nextAll = all;
+        if (all)
+            all->prevAll = s;
+        all = s;
+        ++slabCount;
+        pushPartial(s);
+        return s;
+    }
+
+    void freeSlab(Slab *s)
+    {
+        unlink(s);
+        if (s->prevAll)
+            s->prevAll->nextAll = s->nextAll;
+        else
+            all = s->nextAll;
+        if (s->nextAll)
+            s->nextAll->prevAll = s->prevAll;
+        --slabCount;
+        provider->deallocate(s, SLAB_BYTES, SLAB_BYTES);
+    }
+
+    // 空slab只保留一个，避免在边界上反复向系统要、还
+    void releaseEmpty(Slab *s)
+    {
+        if (emptyKept && emptyKept != s && emptyKept->freeCount == CAPACITY)
+            freeSlab(s);
+        else
+            emptyKept = s;
+    }
+
+    void pushPartial(Slab *s)
+    {
+        s->prev = nullptr;
+        s->next = partial;
+        if (partial)
+            partial->prev = s;
+        partial = s;
+    }
+
+    void unlink(Slab *s)
+    {
+        if (s->prev)
+            s->prev->next = s->next;
+        else if (partial == s)
+            partial = s->next;
+        else
+            return; // 不在partial链表中
+        if (s->next)
+            s->next->prev = s->prev;
+        s->prev = s->next = nullptr;
+    }
+
+private:
+    Slab *partial = nullptr;
+    ChunkProvider *provider;
+    Slab *all = nullptr;
+    Slab *emptyKept = nullptr;
+    size_t slabCount = 0;
+    size_t doubleFrees = 0;
+    size_t invalidFrees = 0;
+};
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include "bitmapSlab.hpp"
+#include "../17_allocatorBench/allocators.hpp"
+using namespace std;
+
+// 3_perClassAllocator的Screen(allocators.hpp中有同一份)去掉了next：空位记录在slab的位图中，对象只剩下自己的数据
+class SlimScreen
+{
+public:
+    SlimScreen(int x) : id(x) {}
+    int get() { return id; }
+
+    void *operator new(size_t size)
+    {
+        if (size != sizeof(SlimScreen))
+            return ::operator new(size);
+        return pool.allocate();
+    }
+
+    void operator delete(void *ptr, size_t size)
+    {
+        if (size != sizeof(SlimScreen))
+        {
+            ::operator delete(ptr);
+            return;
+        }
+        pool.deallocate(ptr);
+    }
+
+    static inline BitmapSlab<sizeof(int)> pool;
+
+private:
+    int id;
+};
+
+// 16字节的对象，与Airplane一样大
+struct Record
+{
+    long key;
+    long value;
+};
+
+struct Timing
+{
+    double allocNs, freeNs, walkNs;
+};
+
+// 1. 分配N个；2. 随机释放一半；3. 再分配N/2个；4. 按第3步的分配顺序遍历这些对象
+// 返回第3步每次分配、第2步每次释放、第4步每个对象的ns
+template <typename Alloc, typename Free>
+Timing churn(size_t n, Alloc alloc, Free release)
+{
+    vector<Record *> v(n);
+    for (size_t i = 0; i < n; ++i)
+        v[i] = static_cast<Record *>(alloc());
+    vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i)
+        order[i] = i;
+    shuffle(order.begin(), order.end(), mt19937(42));
+
+    auto t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < n / 2; ++i)
+        release(v[order[i]]);
+    auto t1 = chrono::steady_clock::now();
+    vector<Record *> fresh(n / 2);
+    for (size_t i = 0; i < n / 2; ++i)
+    {
+        fresh[i] = static_cast<Record *>(alloc());
+        fresh[i]->key = long(i);
+        fresh[i]->value = 1;
+    }
+    auto t2 = chrono::steady_clock::now();
+    long sum = 0;
+    for (int round = 0; round < 10; ++round)
+        for (Record *r : fresh)
+            sum += r->key + r->value;
+    auto t3 = chrono::steady_clock::now();
+
+    for (size_t i = n / 2; i < n; ++i)
+        release(v[order[i]]);
+    for (Record *r : fresh)
+        release(r);
+    chrono::duration<double, nano> f = t1 - t0, a = t2 - t1, w = t3 - t2;
+    return {a.count() / (n / 2), f.count() / (n / 2), sum ? w.count() / (10 * (n / 2)) : 0};
+}
+
+// 默认对齐取能整除SIZE的最大的2的幂，24、40这样不是16的倍数的大小也能用
+template <size_t SIZE>
+void showLayout()
+{
+    BitmapSlab<SIZE> pool;
+    void *a = pool.allocate();
+    void *b = pool.allocate();
+    cout << "BitmapSlab<" << SIZE << ">: objects per slab = " << BitmapSlab<SIZE>::CAPACITY << ", header = "
+         << BitmapSlab<SIZE>::HEADER << " bytes, stride = " << static_cast<char *>(b) - static_cast<char *>(a)
+         << ", 8-byte aligned: " << boolalpha << (reinterpret_cast<uintptr_t>(a) % 8 == 0) << endl;
+    pool.deallocate(a);
+    pool.deallocate(b);
+}
+
+int main()
+{
+    // Test 1: 与3_perClassAllocator相同的输出，对象从16字节变成4字节
+    {
+        cout << "--- Test 1: Screen without next ---" << endl;
+        cout << "sizeof(Screen) = " << sizeof(Screen) << ", sizeof(SlimScreen) = " << sizeof(SlimScreen)
+             << ", objects per 64KB slab = " << BitmapSlab<sizeof(int)>::CAPACITY
+             << ", header = " << BitmapSlab<sizeof(int)>::HEADER << " bytes" << endl;
+        const size_t N = 8;
+        SlimScreen *p[N];
+        for (size_t i = 0; i < N; ++i)
+            p[i] = new SlimScreen(int(i));
+        for (size_t i = 0; i < N; ++i)
+            cout << p[i] << " ";
+        cout << endl;
+
+        // 先释放2再释放5，再分配两个：free list会先给出p[5]的位置，这里总是先填最低的空位，先给出p[2]的
+        delete p[2];
+        delete p[5];
+        SlimScreen *a = new SlimScreen(100), *b = new SlimScreen(101);
+        cout << "after delete p[2], p[5]: new -> " << a << " (p[2]), " << b << " (p[5])" << endl;
+        p[2] = a;
+        p[5] = b;
+        for (size_t i = 0; i < N; ++i)
+            delete p[i];
+        showLayout<12>();
+        showLayout<24>();
+        showLayout<40>();
+    }
+
+    // Test 2: double free和非法指针，不需要任何额外内存就能发现
+    {
+        cout << "--- Test 2: double free detection ---" << endl;
+        BitmapSlab<sizeof(Record)> pool;
+        void *x = pool.allocate();
+        void *y = pool.allocate();
+        cout << "free x: " << boolalpha << pool.tryDeallocate(x) << endl;
+        cout << "free x again: " << pool.tryDeallocate(x) << endl;
+        cout << "free y + 4: " << pool.tryDeallocate(static_cast<char *>(y) + 4) << endl;
+        cout << "live objects (popcnt) = " << pool.stats().liveObjects << endl;
+        pool.deallocate(y);
+        BitmapSlab<sizeof(Record)>::Stats s = pool.stats();
+        cout << "doubleFrees=" << s.doubleFrees << " invalidFrees=" << s.invalidFrees << " live=" << s.liveObjects << endl;
+    }
+
+    // Test 3: 随机释放一半后再分配，对比Airplane式的free list
+    {
+        cout << "--- Test 3: churn, 1M x 16-byte objects ---" << endl;
+        const size_t N = 1000000;
+        BitmapSlab<sizeof(Record)> slab;
+        Timing freeList{1e9, 1e9, 1e9}, bitmap{1e9, 1e9, 1e9};
+        for (int r = 0; r < 3; ++r)
+        {
+            Timing t = churn(N, []
+                             { return AirplaneAdapter::allocate(sizeof(Record)); },
+                             [](void *p)
+                             { AirplaneAdapter::deallocate(p, sizeof(Record)); });
+            freeList = {min(freeList.allocNs, t.allocNs), min(freeList.freeNs, t.freeNs), min(freeList.walkNs, t.walkNs)};
+            t = churn(N, [&]
+                      { return slab.allocate(); },
+                      [&](void *p)
+                      { slab.deallocate(p); });
+            bitmap = {min(bitmap.allocNs, t.allocNs), min(bitmap.freeNs, t.freeNs), min(bitmap.walkNs, t.walkNs)};
+        }
+        cout << left << setw(24) << "" << right << setw(10) << "alloc" << setw(10) << "free" << setw(10) << "walk" << endl;
+        cout << fixed << setprecision(2);
+        cout << left << setw(24) << "Airplane free list" << right << setw(10) << freeList.allocNs << setw(10)
+             << freeList.freeNs << setw(10) << freeList.walkNs << endl;
+        cout << left << setw(24) << "BitmapSlab<16>" << right << setw(10) << bitmap.allocNs << setw(10)
+             << bitmap.freeNs << setw(10) << bitmap.walkNs << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <cstring>
+#include <string>
+#include "../13_poolAllocatedMixin/poolAllocated.hpp"
+using namespace std;
+
+// 本章用POOL_DEBUG=1编译(见CMakeLists.txt)
+#if !POOL_DEBUG
+#error "build this chapter with -DPOOL_DEBUG=1"
+#endif
+
+// 13_poolAllocatedMixin的Foo
+class Foo : public PoolAllocated<Foo>
+{
+public:
+    long L;
+    char name[12];
+    Foo(long l, const char *s) : L(l)
+    {
+        strncpy(name, s, sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+    }
+};
+
+// 默认的handler打印后abort()；这里只打印，让演示继续下去
+int errors = 0;
+void report(const char *error, const void *ptr, size_t objSize)
+{
+    ++errors;
+    cout << "  [pool debug] " << error << " at " << ptr << " (object size " << objSize << ")" << endl;
+}
+
+int main()
+{
+    ChunkPool::setDebugHandler(report);
+    cout << "sizeof(Foo) = " << sizeof(Foo) << endl;
+
+    // Test 1: double delete。release版本会把同一个slot两次挂上free list，之后两次new得到同一个对象
+    {
+        cout << "--- Test 1: double delete ---" << endl;
+        Foo *a = new Foo(1, "a");
+        delete a;
+        delete a;
+        Foo *b = new Foo(2, "b");
+        Foo *c = new Foo(3, "c");
+        cout << "b = " << b << ", c = " << c << (b == c ? " (same object!)" : " (distinct)") << endl;
+        delete b;
+        delete c;
+    }
+
+    // Test 2: 越界写，delete时发现尾部canary被改写
+    {
+        cout << "--- Test 2: buffer overflow ---" << endl;
+        Foo *a = new Foo(1, "a");
+        char *raw = reinterpret_cast<char *>(a);
+#ifndef POOL_HAS_ASAN
+        memset(raw + sizeof(Foo), 'x', 4); // 越过对象末尾写4个字节
+#else
+        cout << "(under ASan the overflow itself is reported, skipped)" << endl;
+#endif
+        delete a;
+        (void)raw;
+    }
+
+    // Test 3: 释放后写，下一次从free list拿到这个slot时发现
+    {
+        cout << "--- Test 3: write after free ---" << endl;
+        Foo *a = new Foo(1, "a");
+        delete a;
+#ifndef POOL_HAS_ASAN
+        a->L = 42; // 悬空指针，正好改写了free list的next
+#else
+        cout << "(under ASan the dangling write itself is reported, skipped)" << endl;
+#endif
+        Foo *b = new Foo(2, "b");
+        cout << "reused the same slot: " << boolalpha << (a == b) << endl;
+        delete b;
+    }
+
+    // Test 4: 不是从池中分配的指针
+    {
+        cout << "--- Test 4: invalid pointers ---" << endl;
+        Foo *a = new Foo(1, "a");
+        void *volatile bogus = reinterpret_cast<char *>(a) + 8; // 对象中间的地址
+        Foo::operator delete(bogus, sizeof(Foo));
+        delete a;
+    }
+
+    // Test 5: 泄漏的两个对象在池析构(程序退出)时报告，序号对应第几次分配
+    {
+        cout << "--- Test 5: leaks (reported at exit) ---" << endl;
+        new Foo(1, "leaked");
+        Foo *a = new Foo(2, "freed");
+        new Foo(3, "leaked");
+        delete a;
+    }
+
+    ChunkPool::Stats s = Foo::poolStats();
+    cout << "errors = " << errors << ", live = " << s.liveObjects << endl;
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+#include "../11_trimmablePool/chunkPool.hpp"
+using namespace std;
+
+const size_t MB = 1024 * 1024;
+
+// 64字节的节点，链成随机顺序的链表，遍历时每一步都落在不同的页上
+struct Node
+{
+    Node *next;
+    long payload[7];
+};
+
+// 用perf_event_open读dTLB load miss的计数；虚拟机没有暴露PMU、或者权限不够时不可用
+class TlbMissCounter
+{
+public:
+    TlbMissCounter()
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    ~TlbMissCounter()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // 不可用时返回-1
+    long long stop()
+    {
+        long long count = -1;
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &count, sizeof(count)) != sizeof(count))
+                count = -1;
+        }
+#endif
+        return count;
+    }
+
+private:
+    int fd = -1;
+};
+
+// 本进程中由透明大页映射的匿名内存
+long anonHugeKB()
+{
+    ifstream in("/proc/self/smaps_rollup");
+    string key;
+    long kb = 0;
+    while (in >> key)
+    {
+        if (key == "AnonHugePages:")
+        {
+            in >> kb;
+            break;
+        }
+        in.ignore(256, '\n');
+    }
+    return kb;
+}
+
+struct Result
+{
+    double nsPerHop;
+    double missesPerHop; // <0表示不可用
+    long hugeKB;
+};
+
+// 在provider提供的chunk上分配n个节点，按随机顺序链起来，然后沿链表走rounds遍，取最快的一遍
+Result chase(ChunkProvider *provider, size_t n, int rounds)
+{
+    // 每个4KB的page放(4096 - 8) / 64 = 63个节点，1024个page正好是4MB的chunk
+    const size_t objsPer4MB = 1024 * ((4096 - sizeof(void *)) / sizeof(Node));
+    ChunkPool pool(sizeof(Node), alignof(Node), objsPer4MB, objsPer4MB, provider);
+    vector<Node *> nodes(n);
+    for (Node *&p : nodes)
+        p = static_cast<Node *>(pool.allocate());
+    shuffle(nodes.begin(), nodes.end(), mt19937(1));
+    for (size_t i = 0; i < n; ++i)
+        nodes[i]->next = nodes[(i + 1) % n];
+    long hugeKB = anonHugeKB();
+
+    TlbMissCounter counter;
+    Node *p = nodes[0];
+    double best = 1e18;
+    long long misses = -1;
+    for (int r = 0; r < rounds; ++r)
+    {
+        counter.start();
+        auto t0 = chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i)
+            p = p->next;
+        chrono::duration<double, nano> d = chrono::steady_clock::now() - t0;
+        long long m = counter.stop();
+        if (d.count() < best)
+        {
+            best = d.count();
+            misses = m;
+        }
+    }
+    if (!p)
+        cout << "unreachable" << endl;
+    for (Node *q : nodes)
+        pool.deallocate(q);
+    return Result{best / n, misses < 0 ? -1.0 : double(misses) / n, hugeKB};
+}
+
+int main()
+{
+    HugePageChunkProvider hugetlb(HugePageChunkProvider::EXPLICIT);
+    HugePageChunkProvider thp(HugePageChunkProvider::TRANSPARENT);
+
+    // Test 1: 各个provider实际拿到了什么样的内存
+    {
+        cout << "--- Test 1: where the chunks come from ---" << endl;
+        void *a = hugetlb.allocate(4 * MB, 4096);
+        void *b = thp.allocate(4 * MB, 4096);
+        void *c = thp.allocate(64 * 1024, 4096);
+        HugePageChunkProvider::Stats s1 = hugetlb.stats(), s2 = thp.stats();
+        cout << "hugetlb provider: MAP_HUGETLB chunks=" << s1.hugetlbChunks << " THP chunks=" << s1.thpChunks
+             << (s1.hugetlbChunks ? "" : " (no reserved huge pages, fell back to THP)") << endl;
+        cout << "thp provider: THP chunks=" << s2.thpChunks << " small (malloc) chunks=" << s2.smallChunks
+             << " madvise failures=" << s2.madviseFailures << endl;
+        cout << "4MB chunk 2MB-aligned: " << boolalpha << (reinterpret_cast<uintptr_t>(b) % (2 * MB) == 0) << endl;
+        hugetlb.deallocate(a, 4 * MB, 4096);
+        thp.deallocate(b, 4 * MB, 4096);
+        thp.deallocate(c, 64 * 1024, 4096);
+    }
+
+    // Test 2: 随机遍历。32MB能放进这台机器的L3(105MB)，但远超4KB页的TLB覆盖范围；256MB两者都超过
+    {
+        ChunkProvider *providers[] = {&mallocChunkProvider, &thp, &hugetlb};
+        for (size_t n : {size_t(512 * 1024), size_t(4 * 1024 * 1024)})
+        {
+            cout << "--- Test 2: pointer chase over " << n << " x " << sizeof(Node) << "-byte nodes ("
+                 << n * sizeof(Node) / MB << "MB) ---" << endl;
+            cout << left << setw(10) << "provider" << right << setw(12) << "ns/hop" << setw(16) << "dTLB miss/hop"
+                 << setw(16) << "AnonHuge(MB)" << endl;
+            for (ChunkProvider *p : providers)
+            {
+                Result r = chase(p, n, 3);
+                cout << left << setw(10) << p->name() << right << fixed << setprecision(2) << setw(12) << r.nsPerHop
+                     << setw(16);
+                if (r.missesPerHop < 0)
+                    cout << "n/a";
+                else
+                    cout << r.missesPerHop;
+                cout << setw(16) << r.hugeKB / 1024 << endl;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <iostream>
+#include <string>
+#include <complex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include "threadCacheAllocator.hpp"
+using namespace std;
+
+// 5_staticAllocator中的Allocator，外面套一把锁，作为多线程下的对照组
+class LockedAllocator
+{
+private:
+    struct obj
+    {
+        struct obj *next;
+    };
+
+public:
+    void *allocate(size_t size)
+    {
+        lock_guard<mutex> lock(mtx);
+        obj *p;
+        if (!freeStore)
+        {
+            size_t chunk = CHUNK * size;
+            freeStore = p = (obj *)malloc(chunk);
+            for (int i = 0; i < CHUNK - 1; ++i)
+            {
+                p->next = (obj *)((char *)p + size);
+                p = p->next;
+            }
+            p->next = nullptr;
+        }
+        p = freeStore;
+        freeStore = freeStore->next;
+        return p;
+    }
+    void deallocate(void *ptr, size_t size)
+    {
+        lock_guard<mutex> lock(mtx);
+        ((obj *)ptr)->next = freeStore;
+        freeStore = (obj *)ptr;
+    }
+
+private:
+    mutex mtx;
+    obj *freeStore = nullptr;
+    const int CHUNK = 5;
+};
+
+class Foo
+{
+public:
+    long L;
+    string str;
+    static ThreadCacheAllocator alloc;
+
+public:
+    Foo(long l, const string &s) : L(l), str(s) {}
+    static void *operator new(size_t size)
+    {
+        return alloc.allocate(size);
+    }
+    static void operator delete(void *ptr, size_t size)
+    {
+        alloc.deallocate(ptr, size);
+    }
+};
+
+ThreadCacheAllocator Foo::alloc;
+
+class Goo
+{
+public:
+    complex<double> c;
+    static ThreadCacheAllocator alloc;
+
+public:
+    Goo(const complex<double> &x) : c(x) {}
+    static void *operator new(size_t size)
+    {
+        return alloc.allocate(size);
+    }
+    static void operator delete(void *ptr, size_t size)
+    {
+        alloc.deallocate(ptr, size);
+    }
+};
+
+ThreadCacheAllocator Goo::alloc;
+
+// 同样的对象布局，分别挂在两种分配器上做吞吐量对比
+template <typename Alloc>
+class Bar
+{
+public:
+    long L;
+    complex<double> c;
+    static Alloc alloc;
+
+public:
+    Bar(long l) : L(l), c(l, l) {}
+    static void *operator new(size_t size)
+    {
+        return alloc.allocate(size);
+    }
+    static void operator delete(void *ptr, size_t size)
+    {
+        alloc.deallocate(ptr, size);
+    }
+};
+
+template <typename Alloc>
+Alloc Bar<Alloc>::alloc;
+
+// 每个线程反复分配一批对象再全部释放，返回总吞吐量(百万次new+delete每秒)
+template <typename T>
+double throughput(int nThreads, int rounds, int perRound)
+{
+    auto worker = [=]()
+    {
+        vector<T *> p(perRound);
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (int i = 0; i < perRound; ++i)
+                p[i] = new T(i);
+            for (int i = 0; i < perRound; ++i)
+                delete p[i];
+        }
+    };
+    auto start = chrono::steady_clock::now();
+    vector<thread> ts;
+    for (int t = 0; t < nThreads; ++t)
+        ts.emplace_back(worker);
+    for (auto &t : ts)
+        t.join();
+    chrono::duration<double> sec = chrono::steady_clock::now() - start;
+    return double(nThreads) * rounds * perRound / sec.count() / 1e6;
+}
+
+int main()
+{
+    {
+        Foo *p[10];
+        cout << "sizeof(Foo) = " << sizeof(Foo) << endl;
+        for (int i = 0; i < 10; ++i)
+        {
+            p[i] = new Foo(i, "hello");
+            cout << p[i] << " " << p[i]->L << endl;
+        }
+        for (int i = 0; i < 10; ++i)
+            delete p[i];
+    }
+
+    {
+        Goo *p[10];
+        cout << "sizeof(Goo) = " << sizeof(Goo) << endl;
+        for (int i = 0; i < 10; ++i)
+        {
+            p[i] = new Goo(complex<double>(i, i));
+            cout << p[i] << " " << p[i]->c << endl;
+        }
+        for (int i = 0; i < 10; ++i)
+            delete p[i];
+    }
+
+    // 多线程并发创建Foo：每个线程都在自己的缓存上分配，互不干扰
+    {
+        vector<thread> ts;
+        for (int t = 0; t < 4; ++t)
+            ts.emplace_back([t]()
+                            {
+                                vector<Foo *> v;
+                                for (int i = 0; i < 1000; ++i)
+                                    v.push_back(new Foo(t * 1000 + i, "worker"));
+                                for (Foo *f : v)
+                                    delete f; });
+        for (auto &t : ts)
+            t.join();
+        cout << "\nFoo: central fetches = " << Foo::alloc.centralFetchCount()
+             << ", chunks = " << Foo::alloc.chunkCount() << endl;
+    }
+
+    // 先后创建、销毁200个分配器：同时存在的不超过1个，id被重用，不会超过MAX_ALLOCATORS；
+    // 每个新分配器看到的本线程缓存都是空的，上一个分配器留下的条目(已经free的内存)被丢弃
+    {
+        for (int k = 0; k < 200; ++k)
+        {
+            ThreadCacheAllocator a;
+            void *p[40];
+            for (void *&q : p)
+                q = a.allocate(16);
+            for (void *q : p)
+                a.deallocate(q, 16);
+        }
+        cout << "\n200 allocators created and destroyed one after another" << endl;
+    }
+
+    // 吞吐量对比：LockedAllocator vs ThreadCacheAllocator
+    {
+        const int rounds = 200, perRound = 1000;
+        unsigned hw = thread::hardware_concurrency();
+        if (hw == 0)
+            hw = 4;
+        cout << "\nthreads\tlocked(Mops/s)\tthreadCache(Mops/s)" << endl;
+        for (unsigned n = 1; n <= hw; n *= 2)
+        {
+            double locked = throughput<Bar<LockedAllocator>>(n, rounds, perRound);
+            double cached = throughput<Bar<ThreadCacheAllocator>>(n, rounds, perRound);
+            cout << n << "\t" << locked << "\t\t" << cached << endl;
+        }
+    }
+    return 0;
+}
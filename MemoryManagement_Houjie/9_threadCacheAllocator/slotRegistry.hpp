@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdlib>
+#include <mutex>
+
+// 给"每个线程一张定长表、按对象id索引"的设计分配id(ThreadCacheAllocator、23_memoryBudget的MemoryBudget)
+// 1. 同时存在的对象最多N个；对象析构后它的槽位可以被新对象重用；
+// 2. 每个槽位有一个代数(gen)，每次被占用时加1。线程表中的条目也记下代数，
+//    代数不同说明条目属于槽位之前的主人(已经析构)，使用前清零，不能交给新主人；
+// 3. 线程退出时通过forEach在锁下访问各个主人，对象析构时的release也要拿这把锁，
+//    所以不会在另一个线程析构对象的同时调用它。
+// 热路径不访问这里：对象自己记住id和gen，只在构造、析构、线程退出时加锁。
+template <typename T, int N>
+class SlotRegistry
+{
+public:
+    struct Slot
+    {
+        int id;
+        unsigned gen; // 从1开始，零初始化的线程表条目一定与任何在用的槽位不同
+    };
+
+    // 占用一个空闲槽位；N个槽位都被占用时abort(表是定长的，超过上限属于使用错误)
+    static Slot acquire(T *owner)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (int i = 0; i < N; ++i)
+            if (!owners[i])
+            {
+                owners[i] = owner;
+                return Slot{i, ++gens[i]};
+            }
+        std::abort();
+    }
+
+    // 返回后不会再有线程通过forEach访问这个对象
+    static void release(Slot s)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        owners[s.id] = nullptr;
+    }
+
+    // 对每个在用的槽位，在锁下调用f(id, gen, owner)
+    template <typename F>
+    static void forEach(F f)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (int i = 0; i < N; ++i)
+            if (owners[i])
+                f(i, gens[i], owners[i]);
+    }
+
+private:
+    static inline std::mutex mtx;
+    static inline T *owners[N] = {};
+    static inline unsigned gens[N] = {};
+};
@@ -0,0 +1,170 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "slotRegistry.hpp"
+
+// 线程缓存分配器：在5_staticAllocator的Allocator前面加一层每线程的free list缓存
+// 热路径(allocate/deallocate)只访问本线程的缓存，不加锁；
+// 缓存空了或攒太多时，才整批(batch)地和中心链表交换，加锁的次数被摊薄为 1/batch
+class ThreadCacheAllocator
+{
+public:
+    static const int MAX_ALLOCATORS = 64; // 进程内最多同时存在的分配器实例数
+    static const int CHUNK_BATCHES = 8;   // 中心链表为空时，一次向malloc要多少批
+
+private:
+    struct obj
+    {
+        struct obj *next;
+    };
+
+    // 一批对象：用next串起来的单链表
+    struct Batch
+    {
+        obj *head;
+        size_t count;
+    };
+
+    // 某个线程对某个分配器的私有缓存（只作为thread_local存在，零初始化）
+    struct ThreadCache
+    {
+        obj *freeList;
+        size_t count;
+        unsigned gen; // 属于槽位的第几代主人，见SlotRegistry
+    };
+
+    typedef SlotRegistry<ThreadCacheAllocator, MAX_ALLOCATORS> Registry;
+
+    // 每个线程一张表，按分配器id索引；线程退出时把缓存整批还给中心链表
+    struct ThreadCacheTable
+    {
+        ThreadCache caches[MAX_ALLOCATORS];
+        ~ThreadCacheTable()
+        {
+            // 在Registry的锁下进行，分配器不会同时在别的线程析构
+            Registry::forEach([this](int i, unsigned gen, ThreadCacheAllocator *owner)
+                              {
+                if (caches[i].gen == gen && caches[i].count > 0)
+                    owner->releaseToCentral(caches[i], caches[i].count); });
+        }
+    };
+
+public:
+    explicit ThreadCacheAllocator(size_t batch = 32) : BATCH(batch < 1 ? 1 : batch), slot(Registry::acquire(this)) {}
+
+    ~ThreadCacheAllocator()
+    {
+        Registry::release(slot);
+        for (void *chunk : chunks)
+            free(chunk);
+    }
+
+    ThreadCacheAllocator(const ThreadCacheAllocator &) = delete;
+    ThreadCacheAllocator &operator=(const ThreadCacheAllocator &) = delete;
+
+    void *allocate(size_t size)
+    {
+        ThreadCache &tc = cache();
+        if (!tc.freeList)
+            fetchFromCentral(tc, size);
+        obj *p = tc.freeList;
+        tc.freeList = p->next;
+        --tc.count;
+        return p;
+    }
+
+    void deallocate(void *ptr, size_t size)
+    {
+        ThreadCache &tc = cache();
+        obj *p = static_cast<obj *>(ptr);
+        p->next = tc.freeList;
+        tc.freeList = p;
+        // 缓存超过两批就还一批回去，既避免某个线程囤积内存，又保留一批防止抖动
+        if (++tc.count >= 2 * BATCH)
+            releaseToCentral(tc, BATCH);
+    }
+
+    // 以下统计只用于观察，非精确值
+    size_t centralFetchCount() const { return fetches.load(std::memory_order_relaxed); }
+    size_t chunkCount()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return chunks.size();
+    }
+
+private:
+    // 本线程对这个分配器的缓存。代数不同的是槽位上一个分配器留下的，它的内存已经随它析构还给系统，直接丢弃
+    ThreadCache &cache()
+    {
+        ThreadCache &tc = tls.caches[slot.id];
+        if (tc.gen != slot.gen)
+            tc = ThreadCache{nullptr, 0, slot.gen};
+        return tc;
+    }
+
+    // 从本线程缓存头部摘下n个对象，整批挂到中心链表
+    void releaseToCentral(ThreadCache &tc, size_t n)
+    {
+        obj *head = tc.freeList;
+        obj *tail = head;
+        for (size_t i = 1; i < n; ++i)
+            tail = tail->next;
+        tc.freeList = tail->next;
+        tc.count -= n;
+        tail->next = nullptr;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        central.push_back(Batch{head, n});
+    }
+
+    // 从中心链表取一批；中心链表也空了就向malloc要CHUNK_BATCHES批
+    void fetchFromCentral(ThreadCache &tc, size_t size)
+    {
+        if (size < sizeof(obj))
+            size = sizeof(obj);
+        fetches.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (central.empty())
+            carveChunk(size);
+        Batch b = central.back();
+        central.pop_back();
+        tc.freeList = b.head;
+        tc.count = b.count;
+    }
+
+    // 调用者已持有mtx
+    void carveChunk(size_t size)
+    {
+        char *chunk = static_cast<char *>(malloc(CHUNK_BATCHES * BATCH * size));
+        if (!chunk)
+            throw std::bad_alloc();
+        chunks.push_back(chunk);
+        for (int b = 0; b < CHUNK_BATCHES; ++b)
+        {
+            char *base = chunk + b * BATCH * size;
+            obj *p = reinterpret_cast<obj *>(base);
+            for (size_t i = 0; i < BATCH - 1; ++i)
+            {
+                p->next = reinterpret_cast<obj *>(reinterpret_cast<char *>(p) + size);
+                p = p->next;
+            }
+            p->next = nullptr;
+            central.push_back(Batch{reinterpret_cast<obj *>(base), BATCH});
+        }
+    }
+
+private:
+    const size_t BATCH;
+    Registry::Slot slot;
+    std::mutex mtx;             // 只保护central和chunks
+    std::vector<Batch> central; // 中心链表：以批为单位存放
+    std::vector<void *> chunks; // 向malloc要来的大块，析构时归还
+    std::atomic<size_t> fetches{0};
+
+    static inline thread_local ThreadCacheTable tls;
+};